@@ -398,3 +398,79 @@ def _(args: Html5libTestsArgs):
 
     with open(expectedFilePath, "w") as f:
         f.writelines(_resultsToLines(testResults))
+
+
+HTML_PARSER_BENCH_BASELINE = Path(const.PROJECT_CK_DIR) / "bench" / "html-parser.json"
+
+
+class HtmlParserBenchArgs(model.TargetArgs):
+    iterations: int = cli.arg("n", "iterations", "Number of times each corpus is parsed, the fastest run is kept", 5)
+    tolerance: float = cli.arg("t", "tolerance", "Regression allowed against the baseline, in percent", 10.0)
+    save: bool = cli.arg(None, "save", "Save the results as the new baseline")
+
+
+def _buildHtmlParserBench(args: model.TargetArgs) -> builder.ProductScope:
+    scope = builder.TargetScope.use(args)
+    BenchComponent = scope.registry.lookup("html-parser-bench", model.Component)
+
+    if BenchComponent is None:
+        raise RuntimeError("html-parser-bench not found")
+    return builder.build(scope, BenchComponent)[0]
+
+
+def _benchRegressions(baseline: dict, results: dict, tolerance: float) -> list[str]:
+    regressions = []
+    previous = {c["name"]: c for c in baseline["corpora"]}
+    for corpus in results["corpora"]:
+        if corpus["name"] not in previous:
+            continue
+        for mode in ("lexer", "parser"):
+            before = previous[corpus["name"]][mode]
+            after = corpus[mode]
+            if after["mbps"] < before["mbps"] * (1 - tolerance / 100):
+                regressions.append(f"{corpus['name']}/{mode}: {before['mbps']:.2f} -> {after['mbps']:.2f} MB/s")
+            if after["allocsPerKb"] > before["allocsPerKb"] * (1 + tolerance / 100):
+                regressions.append(f"{corpus['name']}/{mode}: {before['allocsPerKb']:.2f} -> {after['allocsPerKb']:.2f} allocs/KB")
+    return regressions
+
+
+@cli.command("html5lib-tests/bench", "Measure the throughput of the HTML lexer and parser")
+def _(args: HtmlParserBenchArgs):
+    _ensureTests()
+
+    bench = _buildHtmlParserBench(args)
+    inputs = sorted(glob.glob(str(HTML5LIB_TESTS_ROOT) + "/tree-construction/*.dat"))
+    res = subprocess.run(
+        [str(bench.path), "-n", str(args.iterations), *inputs],
+        capture_output=True,
+        check=True,
+    )
+    results = json.loads(res.stdout.decode("utf-8"))
+
+    print(f"{'corpus':<16}{'bytes':>12}{'lexer MB/s':>14}{'allocs/KB':>12}{'parser MB/s':>14}{'allocs/KB':>12}")
+    for c in results["corpora"]:
+        print(
+            f"{c['name']:<16}{c['bytes']:>12}"
+            f"{c['lexer']['mbps']:>14.2f}{c['lexer']['allocsPerKb']:>12.2f}"
+            f"{c['parser']['mbps']:>14.2f}{c['parser']['allocsPerKb']:>12.2f}"
+        )
+    print()
+
+    if args.save:
+        HTML_PARSER_BENCH_BASELINE.parent.mkdir(parents=True, exist_ok=True)
+        HTML_PARSER_BENCH_BASELINE.write_text(json.dumps(results, indent=4))
+        print("Saved baseline to", HTML_PARSER_BENCH_BASELINE)
+        return
+
+    if not HTML_PARSER_BENCH_BASELINE.exists():
+        print(f"{vt100.YELLOW}No baseline found at {HTML_PARSER_BENCH_BASELINE}, run with --save to create one.{vt100.RESET}")
+        return
+
+    baseline = json.loads(HTML_PARSER_BENCH_BASELINE.read_text())
+    regressions = _benchRegressions(baseline, results, args.tolerance)
+    for r in regressions:
+        print(f"  {vt100.RED}{r}{vt100.RESET}")
+
+    if regressions:
+        raise RuntimeError(f"{len(regressions)} regressions against the baseline (tolerance {args.tolerance}%)")
+    print(f"{vt100.GREEN}No regressions against the baseline{vt100.RESET}")
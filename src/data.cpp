@@ -0,0 +1,195 @@
+module;
+
+#include <karm/macros>
+
+export module PaperMuncher:data;
+
+import Karm.Core;
+import Karm.Gc;
+
+import Vaev.Engine;
+
+using namespace Karm;
+using namespace Karm::Literals;
+
+namespace PaperMuncher {
+
+// MARK: Records ---------------------------------------------------------------
+
+// https://www.rfc-editor.org/rfc/rfc4180#section-2
+static Vec<Vec<String>> _parseCsv(Str text) {
+    Vec<Vec<String>> rows;
+    Vec<String> row;
+    StringBuilder field;
+    bool quoted = false;
+
+    auto endField = [&] {
+        row.pushBack(field.take());
+    };
+
+    auto endRow = [&] {
+        endField();
+        rows.pushBack(std::move(row));
+        row = {};
+    };
+
+    Io::SScan s{text};
+    while (not s.ended()) {
+        if (quoted) {
+            if (s.skip("\"\"")) {
+                field.append('"');
+            } else if (s.skip('"')) {
+                quoted = false;
+            } else {
+                field.append(s.peek());
+                s.next();
+            }
+        } else if (s.skip('"')) {
+            quoted = true;
+        } else if (s.skip(',')) {
+            endField();
+        } else if (s.skip("\r\n") or s.skip('\n')) {
+            endRow();
+        } else {
+            field.append(s.peek());
+            s.next();
+        }
+    }
+
+    if (field.len() or row.len())
+        endRow();
+
+    return rows;
+}
+
+// Parses the records used to fill a template, either a JSON array of objects
+// (or a single object) or a CSV table whose first row names the fields.
+export Res<Vec<Serde::Value>> parseRecords(Str text, Str suffix) {
+    Vec<Serde::Value> records;
+
+    if (eqCi(suffix, "csv"s)) {
+        auto rows = _parseCsv(text);
+        if (not rows.len())
+            return Ok(records);
+
+        auto& header = rows[0];
+        for (usize i = 1; i < rows.len(); i++) {
+            Serde::Object record;
+            for (usize j = 0; j < min(header.len(), rows[i].len()); j++)
+                record.put(header[j], rows[i][j]);
+            records.pushBack(std::move(record));
+        }
+        return Ok(records);
+    }
+
+    auto json = try$(Json::parse(text));
+    if (json.isArray()) {
+        for (auto const& record : json.asArray())
+            records.pushBack(record);
+    } else if (json.isObject()) {
+        records.pushBack(json);
+    } else {
+        return Error::invalidData("expected an array of records");
+    }
+
+    return Ok(records);
+}
+
+// MARK: Substitution ----------------------------------------------------------
+
+// Resolves a dotted path like "customer.name" against a record.
+static String _lookupField(Serde::Value const& record, Str path) {
+    Serde::Value curr = record;
+    for (auto part : iterSplit(path, '.')) {
+        if (not curr.isObject())
+            return ""s;
+        auto next = curr.asObject().lookup(part);
+        if (not next)
+            return ""s;
+        curr = next.take();
+    }
+
+    if (curr.isStr())
+        return curr.asStr();
+
+    if (curr.isNull())
+        return ""s;
+
+    Io::StringWriter sw;
+    (void)Json::unparse(sw, curr);
+    return sw.take();
+}
+
+// Replaces every {{ field }} placeholder in text by the matching record field.
+export String substitute(Str text, Serde::Value const& record) {
+    StringBuilder sb;
+    Io::SScan s{text};
+    while (not s.ended()) {
+        if (not s.skip("{{")) {
+            sb.append(s.peek());
+            s.next();
+            continue;
+        }
+
+        // NOTE: Everything consumed is kept, to give back the original
+        //       text of an unterminated placeholder.
+        StringBuilder raw;
+        raw.append("{{"s);
+
+        while (s.skip(' '))
+            raw.append(' ');
+
+        StringBuilder path;
+        while (not s.ended() and not s.ahead("}}") and s.peek() != ' ') {
+            path.append(s.peek());
+            raw.append(s.peek());
+            s.next();
+        }
+
+        while (s.skip(' '))
+            raw.append(' ');
+
+        if (not s.skip("}}")) {
+            // Unterminated placeholder, keep it as is.
+            sb.append(raw.str());
+            continue;
+        }
+
+        sb.append(_lookupField(record, path.str()));
+    }
+    return sb.take();
+}
+
+// Fills the placeholders of a cloned template document, in text content and
+// attribute values, and returns the images whose source changed and need to
+// be fetched again.
+export Vec<Gc::Ref<Vaev::Dom::Element>> substituteDocument(Vaev::Dom::Document& document, Serde::Value const& record) {
+    Vec<Gc::Ref<Vaev::Dom::Element>> images;
+
+    for (auto node : document.iterDepthFirst()) {
+        if (auto text = node->is<Vaev::Dom::Text>()) {
+            if (contains(text->data(), "{{"s))
+                text->setData(substitute(text->data(), record));
+            continue;
+        }
+
+        auto el = node->is<Vaev::Dom::Element>();
+        if (not el)
+            continue;
+
+        Vec<Pair<Vaev::Dom::QualifiedName, String>> changes;
+        for (auto const& [name, value] : el->attributes)
+            if (contains(value, "{{"s))
+                changes.pushBack({name, substitute(value, record)});
+
+        for (auto& [name, value] : changes) {
+            el->setAttribute(name, value);
+            if (el->qualifiedName == Vaev::Html::IMG_TAG and name == Vaev::Html::SRC_ATTR)
+                images.pushBack(el.upgrade());
+        }
+    }
+
+    return images;
+}
+
+} // namespace PaperMuncher
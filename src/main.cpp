@@ -1,6 +1,10 @@
 #include <karm/entry>
+#include <new>
+#include <stdlib.h>
 
 import Karm.Cli;
+import Karm.Core;
+import Karm.Http;
 import Karm.Print;
 import Karm.Logger;
 import Karm.Math;
@@ -12,6 +16,37 @@ using namespace Karm;
 using namespace Karm::Literals;
 using namespace Karm::Ref::Literals;
 
+// MARK: Allocations -----------------------------------------------------------
+
+// NOTE: Counts the allocations going through the global operator new in the
+//       phases reported by --timings, the counter does nothing otherwise.
+void* operator new(std::size_t size) {
+    Vaev::Perf::countAllocation();
+    if (auto* ptr = malloc(size ? size : 1))
+        return ptr;
+    panic("out of memory");
+}
+
+void* operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* ptr) noexcept {
+    free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+    free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+    free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept {
+    free(ptr);
+}
+
 template <Vaev::ValueParseable T>
     requires(not Meta::Enum<T>)
 struct Cli::ValueParser<T> {
@@ -49,9 +84,14 @@ Async::Task<> entryPointAsync(Sys::Env& env, Async::CancellationToken ct) {
     auto sandboxedArg = Cli::flag(NONE, "sandboxed"s, "Disallow access to local files and the network"s);
     auto verboseArg = Cli::flag(NONE, "verbose"s, "Enable verbose logging"s);
     auto quietArg = Cli::flag(NONE, "quiet"s, "Suppress all logging except fatal errors"s);
+    auto inFlightArg = Cli::option<isize>(NONE, "in-flight"s, "Number of input documents in flight at once, interleaved on a single thread (default: 1)"s, 1);
+    auto fetchJobsArg = Cli::option<isize>(NONE, "fetch-jobs"s, "Number of subresources of a document fetched concurrently (default: 8)"s, 8);
+    auto serveArg = Cli::option<Opt<isize>>(NONE, "serve"s, "Run as a render server listening on the given local TCP port"s, NONE);
+    auto timingsArg = Cli::option<Opt<Str>>(NONE, "timings"s, "Report per-phase timings and counters as JSON to this file, or - for stderr"s, NONE);
+    auto traceArg = Cli::option<Opt<Str>>(NONE, "trace"s, "Record a trace of the render pipeline in the Chrome trace event format to this file"s, NONE);
     Cli::Section runtimeSection{
         "Runtime Options"s,
-        {sandboxedArg, verboseArg, quietArg},
+        {sandboxedArg, verboseArg, quietArg, inFlightArg, fetchJobsArg, serveArg, timingsArg, traceArg},
     };
 
     auto inputsArg = Cli::operand<Vec<Str>>("inputs"s, "Input files (default: stdin)"s, {"-"s});
@@ -59,11 +99,14 @@ Async::Task<> entryPointAsync(Sys::Env& env, Async::CancellationToken ct) {
     auto batchArg = Cli::option<PaperMuncher::Batch>(NONE, "batch"s, "How to handle multiple input documents (default: concat)"s, PaperMuncher::Batch::CONCAT);
     auto formatArg = Cli::option<Opt<Ref::Uti>>('f', "format"s, "Override the output format (default: inferred from the output file extension)"s, NONE);
     auto densityArg = Cli::option<Vaev::Resolution>(NONE, "density"s, "Pixel density of the output document, in CSS resolution units (e.g. 96dpi)"s, Vaev::Resolution::fromDppx(1));
+    auto downsampleImagesArg = Cli::flag(NONE, "downsample-images"s, "Downsample images to the resolution they are printed at, given by --density"s);
+    auto dataArg = Cli::option<Opt<Str>>(NONE, "data"s, "Render the input as a template, once per record of this JSON or CSV file"s, NONE);
 
     Cli::Section inOutSection{
         .title = "Input/Output Options"s,
-        .options = {inputsArg, outputArg, batchArg, formatArg, densityArg},
-        .epilog = "With multiple inputs, batch mode 'separate' writes one output file per input, named after the source file."s
+        .options = {inputsArg, outputArg, batchArg, formatArg, densityArg, downsampleImagesArg, dataArg},
+        .epilog = "With multiple inputs, batch mode 'separate' writes one output file per input, named after the source file.\n"
+                  "With --data, {{ field }} placeholders in the template text and attributes are filled from each record."s
     };
 
     enum struct PaperList {
@@ -170,13 +213,39 @@ Async::Task<> entryPointAsync(Sys::Env& env, Async::CancellationToken ct) {
         level = FATAL;
     setLogLevel(level);
 
+    // NOTE: The report outputs are opened upfront, creating files is not
+    //       allowed anymore once sandboxed.
+    Opt<Sys::File> timings = NONE;
+    if (auto [path] = timingsArg.value()) {
+        Vaev::Perf::enable();
+        if (path != "-"s)
+            timings = co_try$(Sys::File::create(Ref::parseUrlOrPath(path, env.cwd())));
+    }
+
+    Opt<Sys::File> trace = NONE;
+    if (auto [path] = traceArg.value()) {
+        Vaev::Perf::startTrace();
+        if (path != "-"s)
+            trace = co_try$(Sys::File::create(Ref::parseUrlOrPath(path, env.cwd())));
+    }
+
     if (sandboxedArg.value())
         co_try$(Sys::enterSandbox());
 
+    if (inFlightArg.value() < 1)
+        co_return Error::invalidInput("--in-flight must be at least 1");
+
+    if (fetchJobsArg.value() < 1)
+        co_return Error::invalidInput("--fetch-jobs must be at least 1");
+
+    if (auto port = serveArg.value(); port and (*port < 1 or *port > 65535))
+        co_return Error::invalidInput("--serve expects a port between 1 and 65535");
+
     PaperMuncher::Option options{};
 
     options.scale = scaleArg.value();
     options.density = densityArg.value();
+    options.downsampleImages = downsampleImagesArg.value();
     options.width = widthArg.value();
     options.height = heightArg.value();
     options.background = backgroundArg.value();
@@ -184,6 +253,9 @@ Async::Task<> entryPointAsync(Sys::Env& env, Async::CancellationToken ct) {
     options.orientation = orientationArg.value();
     options.margins = marginArg.value();
     options.batch = batchArg.value();
+    options.inFlight = static_cast<usize>(inFlightArg.value());
+    options.fetchConcurrency = static_cast<usize>(fetchJobsArg.value());
+    options.sandboxed = sandboxedArg.value();
 
     Vec<Ref::Url> inputs;
     for (auto& i : inputsArg.value())
@@ -210,5 +282,50 @@ Async::Task<> entryPointAsync(Sys::Env& env, Async::CancellationToken ct) {
     options.extend = extendArg.value();
 
     auto client = PaperMuncher::defaultHttpClient(sandboxedArg.value());
-    co_return co_await PaperMuncher::runBatchAsync(client, inputs, output, options, ct);
+
+    if (auto [port] = serveArg.value()) {
+        // NOTE: The header and footer come from the command line, they are
+        //       loaded once with the same access as a regular run.
+        auto service = co_trya$(PaperMuncher::createServiceAsync(
+            client,
+            PaperMuncher::serviceHttpClient(sandboxedArg.value()),
+            options,
+            ct
+        ));
+        co_return co_await Http::serveAsync(
+            service,
+            {
+                .name = "Paper-Muncher"s,
+                .addr = Sys::Ip4::localhost(static_cast<u16>(port)),
+            },
+            ct
+        );
+    }
+
+    Res<> result = Ok();
+    if (auto [data] = dataArg.value()) {
+        if (inputs.len() != 1)
+            co_return Error::invalidInput("--data expects a single template input");
+
+        result = co_await PaperMuncher::runTemplateAsync(
+            client,
+            first(inputs),
+            Ref::parseUrlOrPath(data, env.cwd()),
+            output,
+            options,
+            ct
+        );
+    } else {
+        result = co_await PaperMuncher::runBatchAsync(client, inputs, output, options, ct);
+    }
+
+    // NOTE: The reports are also written when the run failed, they tell how
+    //       far it went.
+    if (Vaev::Perf::enabled())
+        co_try$(PaperMuncher::writeReport(Vaev::Perf::report(), timings));
+
+    if (traceArg.value())
+        co_try$(PaperMuncher::writeReport(Vaev::Perf::trace(), trace));
+
+    co_return result;
 }
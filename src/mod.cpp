@@ -19,6 +19,8 @@ import Karm.Ref;
 
 import Vaev.Engine;
 
+import :data;
+
 using namespace Karm;
 using namespace Karm::Literals;
 using namespace Karm::Math::Literals;
@@ -66,13 +68,37 @@ Rc<Http::Transport> _createHttpTransport(bool sandboxed) {
     });
 }
 
-export Rc<Http::Client> defaultHttpClient(bool sandboxed) {
-    auto transport = _createHttpTransport(sandboxed);
+// The render server takes urls from any local client, documents and their
+// subresources can only come from the network, or from the parent process
+// when sandboxed, never from the local files of the user running it.
+Rc<Http::Transport> _createServiceTransport(bool sandboxed) {
+    if (sandboxed) {
+        return Http::multiplexTransport({
+            Http::cacheTransport(Http::pipeTransport()),
+            Http::localTransport({"bundle"s, "data"s}),
+        });
+    }
+
+    return Http::multiplexTransport({
+        Http::cacheTransport(Http::httpTransport()),
+        Http::localTransport({"bundle"s, "data"s}),
+    });
+}
+
+Rc<Http::Client> _createHttpClient(Rc<Http::Transport> transport) {
     auto client = makeRc<Http::Client>(transport);
     client->userAgent = "Mozilla/5.0 Paper-Muncher/" stringify$(__ck_version_value) ""s;
     return client;
 }
 
+export Rc<Http::Client> defaultHttpClient(bool sandboxed) {
+    return _createHttpClient(_createHttpTransport(sandboxed));
+}
+
+export Rc<Http::Client> serviceHttpClient(bool sandboxed) {
+    return _createHttpClient(_createServiceTransport(sandboxed));
+}
+
 export struct Option {
     Vaev::Resolution scale = Vaev::Resolution::fromDppx(1);
     Vaev::Resolution density = Vaev::Resolution::fromDppx(1);
@@ -90,6 +116,18 @@ export struct Option {
     Opt<Ref::Url> footer = NONE;
     Union<Vaev::Keywords::Auto, Vaev::AbsoluteLength> headerSize = Vaev::Keywords::AUTO;
     Union<Vaev::Keywords::Auto, Vaev::AbsoluteLength> footerSize = Vaev::Keywords::AUTO;
+    usize inFlight = 1; //< Maximum number of documents in flight, they share one thread.
+    usize fetchConcurrency = 8; //< Subresources of a document fetched concurrently.
+    bool downsampleImages = false;
+    bool sandboxed = false;
+
+    void resolveFlow() {
+        if (flow == Flow::AUTO)
+            flow =
+                outputFormat == Ref::Uti::PUBLIC_PDF
+                    ? Flow::PAGINATE
+                    : Flow::CONTINUOUS;
+    }
 
     auto derivePrintSettings() const -> Print::Settings {
 
@@ -120,6 +158,15 @@ export struct Option {
         };
     }
 
+    auto deriveLoaderOptions() const -> Vaev::Loader::Options {
+        Vaev::Loader::Options options{
+            .fetchConcurrency = this->fetchConcurrency,
+        };
+        if (this->downsampleImages)
+            options.downsamplingDensity = this->density.toDppx() * this->scale.toDppx();
+        return options;
+    }
+
     Vaev::Style::Media deriveMedia() {
         Vaev::Layout::Resolver resolver;
         auto width = this->width ? resolver.resolve(*this->width) : 800_au;
@@ -188,82 +235,320 @@ struct HeaderFooterDecorator : Vaev::Driver::PageDecorator {
     }
 };
 
-Async::Task<> runSingleAsync(
+Async::Task<> _loadDecoratorAsync(
     Rc<Http::Client> client,
-    Ref::Url const& input,
-    Print::Printer& output,
+    Option const& options,
+    HeaderFooterDecorator& decorator,
+    Async::CancellationToken ct
+) {
+    if (auto& [header] = options.header) {
+        logInfo("loading header {}...", header);
+        auto window = Vaev::Dom::Window::create(client, options.deriveLoaderOptions());
+        co_trya$(window->loadLocationAsync(header, Ref::Uti::PUBLIC_OPEN, ct));
+        decorator.headerWindow = window;
+    }
+
+    decorator.headerSize = options.headerSize;
+
+    if (auto& [footer] = options.footer) {
+        logInfo("loading footer {}...", footer);
+        auto window = Vaev::Dom::Window::create(client, options.deriveLoaderOptions());
+        co_trya$(window->loadLocationAsync(footer, Ref::Uti::PUBLIC_OPEN, ct));
+        decorator.footerWindow = window;
+    }
+
+    decorator.footerSize = options.footerSize;
+
+    co_return Ok();
+}
+
+// Loads the header and footer once, for every document rendered with the
+// same options, they are laid out again for each page size but only fetched
+// and parsed here.
+Async::Task<Rc<HeaderFooterDecorator>> _createDecoratorAsync(
+    Rc<Http::Client> client,
+    Option const& options,
+    Async::CancellationToken ct
+) {
+    auto decorator = makeRc<HeaderFooterDecorator>();
+    co_trya$(_loadDecoratorAsync(client, options, *decorator, ct));
+    co_return Ok(decorator);
+}
+
+// Turns the render of a continuous document into a single page.
+Print::Page _continuousPage(
+    Vaev::Driver::RenderResult& render,
+    Vaev::Dom::Document const& document,
+    Vaev::Style::Media const& media,
+    Option const& options
+) {
+    auto scene = render.scenes;
+
+    if (options.background.has())
+        scene = makeRc<Scene::Clear>(scene, Vaev::resolve(*options.background, Gfx::ALPHA));
+
+    // NOTE: Override the background of HTML document, since no
+    //       one really expect a html document to be transparent
+    else if (document.documentElement()->namespaceUri() == Vaev::Html::NAMESPACE) {
+        scene = makeRc<Scene::Clear>(scene, Gfx::WHITE);
+    }
+
+    Math::Vec2Au size{
+        media.width,
+        media.height,
+    };
+
+    if (options.extend == Extend::FIT) {
+        auto overflow = render.frag->scrollableOverflow();
+        size.width = overflow.width;
+        size.height = overflow.height;
+    }
+
+    return {
+        size.cast<f64>(),
+        scene,
+    };
+}
+
+// Loads and lays out a single input, handing every resulting page to onPage
+// in order as it is produced.
+template <typename OnPage>
+Async::Task<> _renderPagesAsync(
+    Rc<Http::Client> client,
+    Ref::Url input,
     Option options,
+    Rc<HeaderFooterDecorator> decorator,
+    OnPage onPage,
     Async::CancellationToken ct
 ) {
     logInfo("loading {}...", input);
-    auto window = Vaev::Dom::Window::create(client);
+    auto window = Vaev::Dom::Window::create(client, options.deriveLoaderOptions());
     co_trya$(window->loadLocationAsync(input, Ref::Uti::PUBLIC_OPEN, ct));
 
     logInfo("rendering {}...", input);
     if (options.flow == Flow::PAGINATE) {
-        Vaev::Layout::Resolver resolver;
-        HeaderFooterDecorator decorator;
-        if (auto& [header] = options.header) {
-            logInfo("loading header {}...", header);
-            auto window = Vaev::Dom::Window::create(client);
-            co_trya$(window->loadLocationAsync(header, Ref::Uti::PUBLIC_OPEN, ct));
-            decorator.headerWindow = window;
-        }
-
-        decorator.headerSize = options.headerSize;
-
-        if (auto& [footer] = options.footer) {
-            logInfo("loading footer {}...", footer);
-            auto window = Vaev::Dom::Window::create(client);
-            co_trya$(window->loadLocationAsync(footer, Ref::Uti::PUBLIC_OPEN, ct));
-            decorator.footerWindow = window;
-        }
-
-        decorator.footerSize = options.footerSize;
-
         auto settings = options.derivePrintSettings();
-        window->print(settings, decorator) | ForEach([&](Print::Page& page) {
-            page.print(
-                output,
-                {.showBackgroundGraphics = true}
-            );
+        window->print(settings, *decorator) | ForEach([&](Print::Page& page) {
+            onPage(page);
         });
     } else {
         auto media = options.deriveMedia();
         window->changeMedia(media);
 
-        auto scene = window->render();
-
-        if (options.background.has())
-            scene = makeRc<Scene::Clear>(scene, Vaev::resolve(*options.background, Gfx::ALPHA));
+        auto page = _continuousPage(window->ensureRender(), *window->document(), media, options);
+        onPage(page);
+    }
 
-        // NOTE: Override the background of HTML document, since no
-        //       one really expect a html document to be transparent
-        else if (window->document()->documentElement()->namespaceUri() == Vaev::Html::NAMESPACE) {
-            scene = makeRc<Scene::Clear>(scene, Gfx::WHITE);
-        }
+    co_return Ok();
+}
 
-        Math::Vec2Au size{
-            media.width,
-            media.height,
-        };
+Async::Task<> runSingleAsync(
+    Rc<Http::Client> client,
+    Ref::Url const& input,
+    Print::Printer& output,
+    Option options,
+    Rc<HeaderFooterDecorator> decorator,
+    Async::CancellationToken ct
+) {
+    co_return co_await _renderPagesAsync(
+        client, input, options, decorator,
+        [&](Print::Page& page) {
+            page.print(
+                output,
+                {.showBackgroundGraphics = true}
+            );
+        },
+        ct
+    );
+}
 
-        if (options.extend == Extend::FIT) {
-            auto overflow = window->ensureRender().frag->scrollableOverflow();
-            size.width = overflow.width;
-            size.height = overflow.height;
+// Hands the pages of concurrently rendered documents to the printer in input
+// order. The pages of the first unfinished document go straight to the
+// printer, the pages of the documents after it are only held until every
+// document before them is done.
+struct _ConcatStitcher {
+    Print::Printer& printer;
+    Vec<Vec<Print::Page>> pending = {};
+    Vec<bool> done = {};
+    usize head = 0;
+
+    _ConcatStitcher(Print::Printer& printer, usize documents)
+        : printer(printer) {
+        for (usize i = 0; i < documents; i++) {
+            pending.emplaceBack();
+            done.pushBack(false);
         }
+    }
 
-        Print::Page page = {
-            size.cast<f64>(),
-            scene,
-        };
+    void _print(Print::Page& page) {
         page.print(
-            output,
+            printer,
             {.showBackgroundGraphics = true}
         );
     }
 
+    void add(usize index, Print::Page& page) {
+        if (index == head) {
+            _print(page);
+            return;
+        }
+        pending[index].pushBack(page);
+    }
+
+    void finish(usize index) {
+        done[index] = true;
+        while (head < done.len() and done[head]) {
+            head++;
+            if (head == done.len())
+                break;
+            for (auto& page : pending[head])
+                _print(page);
+            pending[head] = {};
+        }
+    }
+};
+
+// Renders inputs of a concatenated batch until there is none left, handing
+// their pages to the stitcher.
+Async::Task<> _concatWorkerAsync(
+    Rc<Http::Client> client,
+    Vec<Ref::Url> const& inputs,
+    usize& next,
+    _ConcatStitcher& stitcher,
+    Option options,
+    Rc<HeaderFooterDecorator> decorator,
+    Async::CancellationToken ct
+) {
+    while (next < inputs.len()) {
+        auto index = next++;
+        co_trya$(_renderPagesAsync(
+            client, inputs[index], options, decorator,
+            [&](Print::Page& page) {
+                stitcher.add(index, page);
+            },
+            ct
+        ));
+        stitcher.finish(index);
+    }
+    co_return Ok();
+}
+
+// Encodes the printed document straight into its destination. Local files
+// are written in place, without first buffering the whole encoded document
+// in memory, anything else goes through the http client.
+Async::Task<> _saveAsync(
+    Rc<Http::Client> client,
+    Print::FilePrinter& printer,
+    Ref::Url const& output,
+    Option const& options,
+    bool lastRequest,
+    Async::CancellationToken ct
+) {
+    logInfo("saving {}...", output);
+
+    if (output.scheme == "file" and not options.sandboxed) {
+        auto file = co_try$(Sys::File::create(output));
+        Vaev::Perf::Scope _{"encode"};
+        co_try$(printer.write(file));
+        co_try$(file.flush());
+        co_return Ok();
+    }
+
+    Io::BufferWriter bw;
+    {
+        Vaev::Perf::Scope _{"encode"};
+        co_try$(printer.write(bw));
+    }
+
+    auto request = Http::Request::from(
+        Http::Method::PUT,
+        output,
+        Http::Body::from(bw.take())
+    );
+    if (lastRequest)
+        request->header.put(Http::Header::CONNECTION, "close"s);
+
+    co_trya$(client->doAsync(request, ct));
+    co_return Ok();
+}
+
+// Inputs of a separate batch, pulled by its workers.
+struct _SeparateQueue {
+    Vec<Ref::Url> const& inputs;
+    usize next = 0;
+    usize unsaved = inputs.len(); //< Inputs whose output is not saved yet.
+
+    // The save started last, every save waits for the previous one to
+    // settle before sending its request.
+    Opt<Async::Future<Res<>>> lastSave = NONE;
+
+    Opt<usize> take() {
+        if (next >= inputs.len())
+            return NONE;
+        return next++;
+    }
+};
+
+// Saves the outputs of a separate batch one after the other, in the order
+// their documents finish rendering. A save only starts once the previous one
+// settled, so the save of the last output knows every other request was
+// answered and closes the connection.
+Async::Task<> _saveSeparateAsync(
+    Rc<Http::Client> client,
+    _SeparateQueue& queue,
+    Print::FilePrinter& printer,
+    Ref::Url fileUrl,
+    Option const& options,
+    Async::CancellationToken ct
+) {
+    Async::Promise<Res<>> saved;
+    auto previous = std::move(queue.lastSave);
+    queue.lastSave = saved.future();
+    if (auto& [future] = previous)
+        (void)co_await future;
+
+    queue.unsaved--;
+    auto res = co_await _saveAsync(client, printer, fileUrl, options, queue.unsaved == 0, ct);
+    saved.resolve(Ok());
+    co_return res;
+}
+
+Async::Task<> _renderSeparateAsync(
+    Rc<Http::Client> client,
+    _SeparateQueue& queue,
+    usize index,
+    Ref::Url output,
+    Option options,
+    Rc<HeaderFooterDecorator> decorator,
+    Async::CancellationToken ct
+) {
+    auto& input = queue.inputs[index];
+    auto fileUrl = output / "{}.{}"_f(input.path.stem(), options.outputFormat.primarySuffix());
+    auto printer = co_try$(
+        Print::FilePrinter::create(
+            options.outputFormat,
+            {
+                .density = options.density.toDppx(),
+            }
+        )
+    );
+    co_trya$(runSingleAsync(client, input, *printer, options, decorator, ct));
+    co_trya$(_saveSeparateAsync(client, queue, *printer, fileUrl, options, ct));
+    co_return Ok();
+}
+
+// Pulls inputs off the shared queue until there is none left, each one
+// rendered with its own window, heap and printer.
+Async::Task<> _separateWorkerAsync(
+    Rc<Http::Client> client,
+    _SeparateQueue& queue,
+    Ref::Url output,
+    Option options,
+    Rc<HeaderFooterDecorator> decorator,
+    Async::CancellationToken ct
+) {
+    while (auto index = queue.take())
+        co_trya$(_renderSeparateAsync(client, queue, *index, output, options, decorator, ct));
     co_return Ok();
 }
 
@@ -274,12 +559,17 @@ export Async::Task<> runBatchAsync(
     Option options,
     Async::CancellationToken ct
 ) {
-    if (options.flow == Flow::AUTO)
-        options.flow =
-            options.outputFormat == Ref::Uti::PUBLIC_PDF
-                ? Flow::PAGINATE
-                : Flow::CONTINUOUS;
+    options.resolveFlow();
+
+    auto decorator = makeRc<HeaderFooterDecorator>();
+    if (options.flow == Flow::PAGINATE)
+        decorator = co_trya$(_createDecoratorAsync(client, options, ct));
 
+    // NOTE: Workers are tasks on the event loop rather than threads, the
+    //       engine relies on interned symbols, non-atomic refcounts and a
+    //       process-wide font database that are not thread safe. Their
+    //       fetches and output writes overlap each other, but styling,
+    //       layout and paint of different documents still run one at a time.
     if (options.batch == Batch::CONCAT) {
         auto printer = co_try$(
             Print::FilePrinter::create(
@@ -289,54 +579,306 @@ export Async::Task<> runBatchAsync(
                 }
             )
         );
-        for (auto& input : inputs)
-            co_trya$(runSingleAsync(
-                client,
-                input,
-                *printer,
-                options,
-                ct
-            ));
-        logInfo("saving {}...", output);
-        Io::BufferWriter bw;
-        co_try$(printer->write(bw));
-        auto request = Http::Request::from(
-            Http::Method::PUT,
-            output,
-            Http::Body::from(bw.take())
-        );
-        request->header.put(Http::Header::CONNECTION, "close"s);
-        co_trya$(client->doAsync(request, ct));
+        if (options.inFlight <= 1) {
+            for (auto& input : inputs)
+                co_trya$(runSingleAsync(
+                    client,
+                    input,
+                    *printer,
+                    options,
+                    decorator,
+                    ct
+                ));
+        } else {
+            // NOTE: Pages are handed to the printer in input order, the same
+            //       sequence of calls a sequential run makes, so the output
+            //       is identical.
+            usize next = 0;
+            auto count = min(options.inFlight, inputs.len());
+            _ConcatStitcher stitcher{*printer, inputs.len()};
+            Vec<Async::Task<>> workers;
+            for (usize i = 0; i < count; i++)
+                workers.pushBack(_concatWorkerAsync(client, inputs, next, stitcher, options, decorator, ct));
+            co_trya$(Vaev::joinAllAsync(std::move(workers)));
+        }
+        co_trya$(_saveAsync(client, *printer, output, options, true, ct));
     } else {
-        for (auto [input, index] : iter(inputs) | Index()) {
-            auto fileUrl = output / "{}.{}"_f(input.path.stem(), options.outputFormat.primarySuffix());
-            auto printer = co_try$(
-                Print::FilePrinter::create(
-                    options.outputFormat,
-                    {
-                        .density = options.density.toDppx(),
-                    }
-                )
-            );
-            co_trya$(runSingleAsync(client, input, *printer, options, ct));
+        _SeparateQueue queue{inputs};
+        auto count = min(max(options.inFlight, 1uz), inputs.len());
+        Vec<Async::Task<>> workers;
+        for (usize i = 0; i < count; i++)
+            workers.pushBack(_separateWorkerAsync(client, queue, output, options, decorator, ct));
+        co_trya$(Vaev::joinAllAsync(std::move(workers)));
+    }
+
+    co_return Ok();
+}
+
+// MARK: Template --------------------------------------------------------------
 
-            logInfo("saving {}...", fileUrl);
-            Io::BufferWriter bw;
-            co_try$(printer->write(bw));
+// Renders one document per record from a single template. The template, its
+// style sheets, images and fonts are loaded and its rules indexed once, each
+// record only pays for a cloned DOM, styling, layout and paint.
+export Async::Task<> runTemplateAsync(
+    Rc<Http::Client> client,
+    Ref::Url const& input,
+    Ref::Url const& data,
+    Ref::Url const& output,
+    Option options,
+    Async::CancellationToken ct
+) {
+    options.resolveFlow();
+
+    logInfo("loading records {}...", data);
+    auto resp = co_trya$(client->getAsync(data, ct));
+    if (not resp->body)
+        co_return Error::invalidInput("response body is missing");
+    auto text = co_trya$(Aio::readAllTextAsync<Utf8>(**resp->body, ct));
+    auto records = co_try$(parseRecords(text, data.path.suffix()));
+
+    logInfo("loading template {}...", input);
+    auto window = Vaev::Dom::Window::create(client, options.deriveLoaderOptions());
+    co_trya$(window->loadLocationAsync(input, Ref::Uti::PUBLIC_OPEN, ct));
+    auto templateDocument = window->document().upgrade();
+
+    HeaderFooterDecorator decorator;
+    if (options.flow == Flow::PAGINATE)
+        co_trya$(_loadDecoratorAsync(client, options, decorator, ct));
+
+    auto settings = options.derivePrintSettings();
+    auto media =
+        options.flow == Flow::PAGINATE
+            ? Vaev::Style::Media::forPrint(settings)
+            : options.deriveMedia();
+
+    Vaev::Style::Computer templateComputer{
+        window->_heap,
+        media,
+        templateDocument->registeredPropertySet,
+        *templateDocument->styleSheets,
+        templateDocument->fontDatabase,
+    };
+    templateComputer.build();
+
+    auto newPrinter = [&] {
+        return Print::FilePrinter::create(
+            options.outputFormat,
+            {
+                .density = options.density.toDppx(),
+            }
+        );
+    };
+
+    Opt<Rc<Print::FilePrinter>> concatPrinter = NONE;
+    if (options.batch == Batch::CONCAT)
+        concatPrinter = co_try$(newPrinter());
+
+    for (auto [record, index] : iter(records) | Index()) {
+        logInfo("rendering record {} of {}...", index + 1, records.len());
+
+        Gc::Heap heap;
+        auto document = Vaev::Dom::cloneDocument(heap, *templateDocument);
+        for (auto& image : substituteDocument(*document, record))
+            (void)co_await Vaev::Loader::fetchImageAsync(*client, image, options.deriveLoaderOptions(), ct);
+
+        Vaev::Style::Computer computer{
+            heap,
+            media,
+            document->registeredPropertySet,
+            *templateDocument->styleSheets,
+            document->fontDatabase,
+            templateComputer._ruleIndex,
+        };
 
-            auto request = Http::Request::from(
-                Http::Method::PUT,
-                fileUrl,
-                Http::Body::from(bw.take())
+        auto printer = concatPrinter ? *concatPrinter : co_try$(newPrinter());
+        auto print = [&](Print::Page& page) {
+            page.print(
+                *printer,
+                {.showBackgroundGraphics = true}
             );
-            if (index + 1 == inputs.len())
-                request->header.put(Http::Header::CONNECTION, "close"s);
+        };
+
+        if (options.flow == Flow::PAGINATE) {
+            Vaev::Driver::print(document, computer, settings, decorator) | ForEach(print);
+        } else {
+            auto render = Vaev::Driver::render(document, computer, {.small = media.viewportSize()});
+            auto page = _continuousPage(render, *document, media, options);
+            print(page);
+        }
 
-            co_trya$(client->doAsync(request, ct));
+        if (not concatPrinter) {
+            auto fileUrl = output / "{}-{}.{}"_f(input.path.stem(), index + 1, options.outputFormat.primarySuffix());
+            co_trya$(_saveAsync(client, *printer, fileUrl, options, index + 1 == records.len(), ct));
         }
     }
 
+    if (auto& [printer] = concatPrinter)
+        co_trya$(_saveAsync(client, *printer, output, options, true, ct));
+
     co_return Ok();
 }
 
+// MARK: Timings ---------------------------------------------------------------
+
+// Writes the timings or the trace collected during the run as JSON, to
+// stderr when no output is given. The output is opened by the caller before
+// entering the sandbox.
+export Res<> writeReport(Serde::Value const& report, Opt<Sys::File>& output) {
+    Io::StringWriter sw;
+    try$(Json::unparse(sw, report));
+    try$(sw.writeRune('\n'));
+    auto json = sw.take();
+
+    if (auto& [file] = output) {
+        try$(file.write(bytes(json)));
+        return file.flush();
+    }
+
+    try$(Sys::err().writeStr(json));
+    return Ok();
+}
+
+// MARK: Server ----------------------------------------------------------------
+
+// Renders a single document for a request of the render server.
+Async::Task<Buf<u8>> _renderRequestAsync(
+    Rc<Http::Client> client,
+    Ref::Url input,
+    Option options,
+    Rc<HeaderFooterDecorator> decorator,
+    Async::CancellationToken ct
+) {
+    options.resolveFlow();
+
+    auto printer = co_try$(
+        Print::FilePrinter::create(
+            options.outputFormat,
+            {
+                .density = options.density.toDppx(),
+            }
+        )
+    );
+    co_trya$(runSingleAsync(client, input, *printer, options, decorator, ct));
+
+    Io::BufferWriter bw;
+    {
+        Vaev::Perf::Scope _{"encode"};
+        co_try$(printer->write(bw));
+    }
+    co_return Ok(bw.take());
+}
+
+// The media type of a rendered document, for the Content-Type of its
+// response.
+Str _mediaTypeOf(Ref::Uti const& format) {
+    auto suffix = format.primarySuffix();
+    if (suffix == "pdf")
+        return "application/pdf";
+    if (suffix == "png")
+        return "image/png";
+    if (suffix == "jpg" or suffix == "jpeg")
+        return "image/jpeg";
+    if (suffix == "bmp")
+        return "image/bmp";
+    if (suffix == "tga")
+        return "image/x-tga";
+    if (suffix == "qoi")
+        return "image/qoi";
+    if (suffix == "svg")
+        return "image/svg+xml";
+    return "application/octet-stream";
+}
+
+Async::Task<> _writeErrorAsync(Rc<Http::ResponseWriter> resp, Http::Code code, Error error, Async::CancellationToken ct) {
+    logWarn("render error: {}", error);
+    resp->code = code;
+    co_return co_await resp->writeJsonAsync(
+        Serde::Object{
+            {"error"s, Str{error.msg()}},
+        },
+        ct
+    );
+}
+
+// Long-lived render service, the http client, its caches, the font database,
+// the property registry and the header and footer stay warm across jobs.
+// The header and footer are loaded once here, with `client`, documents are
+// loaded with `serviceClient`, which can't reach local files.
+//
+//   POST /render {"url": "https://example.com/invoice.html", "format": "pdf"}
+//   GET  /status
+export Async::Task<Rc<Http::Handler>> createServiceAsync(
+    Rc<Http::Client> client,
+    Rc<Http::Client> serviceClient,
+    Option options,
+    Async::CancellationToken ct
+) {
+    auto decorator = co_trya$(_createDecoratorAsync(client, options, ct));
+    auto router = makeRc<Http::Router>();
+
+    router->get(
+        "/status",
+        [](Rc<Http::Request>, Rc<Http::ResponseWriter> resp, Async::CancellationToken ct) -> Async::Task<> {
+            Serde::Object status{
+                {"ready"s, true},
+            };
+            if (Vaev::Perf::enabled())
+                status.put("timings"s, Vaev::Perf::report());
+            co_trya$(resp->writeJsonAsync(status, ct));
+            co_return Ok();
+        }
+    );
+
+    router->post(
+        "/render",
+        [serviceClient, options, decorator](Rc<Http::Request> req, Rc<Http::ResponseWriter> resp, Async::CancellationToken ct) -> Async::Task<> {
+            Serde::Value parameters = co_trya$(req->readJsonAsync(ct));
+
+            Ref::Url input;
+            if (auto value = parameters.getOr("url", NONE); value.isStr()) {
+                input = Ref::Url::parse(value.asStr());
+            } else {
+                co_return Error::invalidInput("missing url key");
+            }
+
+            // NOTE: The client of the service can't reach local files
+            //       either, this only makes for a clearer error.
+            if (input.scheme != "http" and input.scheme != "https" and input.scheme != "data")
+                co_return Error::invalidInput("unsupported url scheme, expected http, https or data");
+
+            auto jobOptions = options;
+            if (auto value = parameters.getOr("format", NONE); value.isStr())
+                jobOptions.outputFormat = Ref::Uti::fromSuffix(value.asStr());
+
+            // NOTE: The request is valid past this point, a failure is on
+            //       the side of the server.
+            auto output = co_await _renderRequestAsync(serviceClient, input, jobOptions, decorator, ct);
+            if (not output)
+                co_return co_await _writeErrorAsync(resp, Http::Code::INTERNAL_SERVER_ERROR, output.none(), ct);
+
+            resp->header.put(Http::Header::CONTENT_TYPE, String{_mediaTypeOf(jobOptions.outputFormat)});
+            co_trya$(resp->writeAsync(bytes(output.unwrap()), ct));
+
+            co_return Ok();
+        }
+    );
+
+    // Requests that can't be understood, missing or invalid parameters.
+    struct ErrorHandler : Http::Handler {
+        Rc<Handler> _next;
+
+        ErrorHandler(Rc<Handler> next)
+            : _next(next) {}
+
+        Async::Task<> handleAsync(Rc<Http::Request> req, Rc<Http::ResponseWriter> resp, Async::CancellationToken ct) override {
+            auto result = co_await _next->handleAsync(req, resp, ct);
+            if (not result)
+                co_return co_await _writeErrorAsync(resp, Http::Code::BAD_REQUEST, result.none(), ct);
+            co_return Ok();
+        }
+    };
+
+    co_return Ok(makeRc<ErrorHandler>(router));
+}
+
 } // namespace PaperMuncher
@@ -0,0 +1,246 @@
+#include <karm/entry>
+#include <new>
+#include <stdlib.h>
+
+import Karm.Core;
+import Karm.Cli;
+import Karm.Diag;
+import Karm.Gc;
+import Karm.Ref;
+
+import Vaev.Engine;
+
+using namespace Karm;
+using namespace Karm::Literals;
+using namespace Vaev;
+
+// MARK: Allocations -----------------------------------------------------------
+
+// NOTE: Counts the allocations going through the global operator new, which
+//       is where the tokens, the builders and the DOM get their memory from.
+static usize _allocations = 0;
+
+void* operator new(std::size_t size) {
+    _allocations++;
+    if (auto* ptr = malloc(size ? size : 1))
+        return ptr;
+    panic("out of memory");
+}
+
+void* operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* ptr) noexcept {
+    free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+    free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+    free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept {
+    free(ptr);
+}
+
+// MARK: Corpus ----------------------------------------------------------------
+
+struct _Corpus {
+    String name;
+    Vec<String> documents = {};
+    usize bytes = 0;
+
+    void add(String document) {
+        bytes += document.len();
+        documents.pushBack(std::move(document));
+    }
+};
+
+// https://github.com/html5lib/html5lib-tests/blob/master/tree-construction/README.md
+static void _addTreeConstructionInputs(_Corpus& corpus, Str dat) {
+    bool inData = false;
+    bool first = true;
+    StringBuilder data;
+
+    usize start = 0;
+    for (usize i = 0; i <= dat.len(); i++) {
+        if (i < dat.len() and dat[i] != '\n')
+            continue;
+        Str line = sub(dat, start, i);
+        start = i + 1;
+
+        if (line == "#data") {
+            inData = true;
+            first = true;
+        } else if (inData and line == "#errors") {
+            corpus.add(data.take());
+            inData = false;
+        } else if (inData) {
+            if (not first)
+                data.append('\n');
+            data.append(line);
+            first = false;
+        }
+    }
+}
+
+static _Corpus _largeTable(usize rows) {
+    StringBuilder sb;
+    sb.append("<!DOCTYPE html><table><thead><tr><th>Id<th>Name<th>Quantity<th>Price<th>Total</thead><tbody>\n"s);
+    for (usize i = 0; i < rows; i++) {
+        sb.append(Io::format(
+            "<tr class=\"row-{}\"><td>{}</td><td>Item {}</td><td align=right>{}</td><td>{}.00</td><td>{}.00</td></tr>\n",
+            i % 2 ? "odd"s : "even"s, i, i, i % 17, i % 101, (i % 17) * (i % 101)
+        ));
+    }
+    sb.append("</tbody></table>\n"s);
+
+    _Corpus corpus{"large-table"s};
+    corpus.add(sb.take());
+    return corpus;
+}
+
+static _Corpus _entityDense(usize paragraphs) {
+    StringBuilder sb;
+    sb.append("<!DOCTYPE html><body>\n"s);
+    for (usize i = 0; i < paragraphs; i++) {
+        // NOTE: Named references with and without a semicolon, a legacy
+        //       one without, decimal and hexadecimal references.
+        sb.append(Io::format(
+            "<p title=\"&quot;{}&quot; &amp; co\">Caf&eacute; &amp; cr&egrave;me br&ucirc;l&eacute;e &lt;{}&gt; "
+            "&#x263A; &#8364;{} &notin; &copy 2024 &NotNestedGreaterGreater; &ampx &CounterClockwiseContourIntegral;</p>\n",
+            i, i, i % 100
+        ));
+    }
+
+    _Corpus corpus{"entity-dense"s};
+    corpus.add(sb.take());
+    return corpus;
+}
+
+static _Corpus _nestedInline(usize depth, usize repeat) {
+    Array<Str, 10> tags = {"b", "i", "em", "strong", "span", "u", "s", "small", "code", "a"};
+
+    StringBuilder sb;
+    sb.append("<!DOCTYPE html><body>\n"s);
+    for (usize r = 0; r < repeat; r++) {
+        sb.append("<p>"s);
+        for (usize d = 0; d < depth; d++)
+            sb.append(Io::format("<{}>level {} ", tags[d % tags.len()], d));
+
+        // NOTE: Every other paragraph closes its elements in the order they
+        //       were opened, which runs the adoption agency algorithm.
+        for (usize d = 0; d < depth; d++) {
+            usize index = r % 2 ? d : depth - d - 1;
+            sb.append(Io::format("</{}>", tags[index % tags.len()]));
+        }
+        sb.append("</p>\n"s);
+    }
+
+    _Corpus corpus{"nested-inline"s};
+    corpus.add(sb.take());
+    return corpus;
+}
+
+// MARK: Measuring -------------------------------------------------------------
+
+// The size of the chunks the loader feeds the parser with.
+static constexpr usize _CHUNK_SIZE = 16 * 1024;
+
+// Drops every token, to measure the lexer alone.
+// NOTE: Without tree construction the lexer is never switched to the
+//       RAWTEXT, RCDATA or script states.
+struct _NullSink : Html::HtmlSink {
+    void accept(Html::HtmlToken&, Diag::Collector&) override {}
+    void acceptRun(Str, Io::Loc, Diag::Collector&) override {}
+};
+
+static void _parse(Bytes input, bool lexerOnly) {
+    Gc::Heap gc;
+    auto dom = Dom::Document::create(gc, Ref::Url(), Ref::Uti::PUBLIC_HTML);
+    Html::HtmlParser parser{gc, dom};
+
+    _NullSink sink;
+    if (lexerOnly)
+        parser._lexer._sink = &sink;
+
+    Diag::Collector diags;
+    for (usize i = 0; i < input.len(); i += _CHUNK_SIZE)
+        parser.feed(sub(input, i, min(i + _CHUNK_SIZE, input.len())), diags);
+    parser.end(diags);
+}
+
+// Parses the whole corpus `iterations` times, keeping the fastest run.
+static Serde::Object _measure(_Corpus const& corpus, usize iterations, bool lexerOnly) {
+    u64 best = Limits<u64>::MAX;
+    usize allocations = 0;
+    for (usize i = 0; i < iterations; i++) {
+        _allocations = 0;
+        auto start = Sys::instant();
+        for (auto const& document : corpus.documents)
+            _parse(bytes(document), lexerOnly);
+        best = min(best, (Sys::instant() - start).toUSecs());
+        allocations = _allocations;
+    }
+
+    // NOTE: Bytes per microsecond are megabytes per second.
+    return Serde::Object{
+        {"mbps"s, corpus.bytes / static_cast<f64>(max(best, u64{1}))},
+        {"allocsPerKb"s, allocations / (max(corpus.bytes, 1uz) / 1024.0)},
+    };
+}
+
+Async::Task<> entryPointAsync(Sys::Env& env, [[maybe_unused]] Async::CancellationToken ct) {
+    auto iterationsArg = Cli::option<isize>('n', "iterations"s, "Number of times each corpus is parsed, the fastest run is kept (default: 5)"s, 5);
+    auto inputsArg = Cli::operand<Vec<Str>>("inputs"s, "html5lib tree-construction test files (.dat) to add to the corpus"s, {});
+
+    Cli::Command cmd{
+        "html-parser-bench"s,
+        "Measure the throughput of the HTML lexer and parser."s,
+        {
+            Cli::Section{
+                "Benchmark Options"s,
+                {iterationsArg, inputsArg},
+            },
+        }
+    };
+
+    co_trya$(cmd.execAsync(env));
+    if (not cmd)
+        co_return Ok();
+
+    if (iterationsArg.value() < 1)
+        co_return Error::invalidInput("at least one iteration is required");
+    auto iterations = static_cast<usize>(iterationsArg.value());
+
+    Vec<_Corpus> corpora;
+    if (inputsArg.value().len()) {
+        _Corpus html5lib{"html5lib"s};
+        for (auto input : inputsArg.value()) {
+            auto url = Ref::parseUrlOrPath(input, env.cwd());
+            auto dat = co_try$(Sys::readAllText<Utf8>(url));
+            _addTreeConstructionInputs(html5lib, dat);
+        }
+        corpora.pushBack(std::move(html5lib));
+    }
+    corpora.pushBack(_largeTable(20000));
+    corpora.pushBack(_entityDense(10000));
+    corpora.pushBack(_nestedInline(64, 256));
+
+    Serde::Array results;
+    for (auto const& corpus : corpora) {
+        results.pushBack(Serde::Object{
+            {"name"s, corpus.name},
+            {"documents"s, corpus.documents.len()},
+            {"bytes"s, corpus.bytes},
+            {"lexer"s, _measure(corpus, iterations, true)},
+            {"parser"s, _measure(corpus, iterations, false)},
+        });
+    }
+
+    co_return Json::unparse(Sys::out(), Serde::Object{{"corpora"s, results}});
+}
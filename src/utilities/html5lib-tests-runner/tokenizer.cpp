@@ -209,6 +209,15 @@ export Res<Result> run(Str inputStr) {
         return HtmlToken{HtmlToken::START_TAG, Symbol::from(val.asStr())};
     });
 
+    // NOTE: Inputs are fed as they would arrive from the loader, which
+    //       runs the text run fast path through the default acceptRun() of
+    //       the collector. Lone surrogates only survive write(), feed()
+    //       decodes them as U+FFFD like any other invalid UTF-8.
+    bool surrogates = false;
+    for (auto rune : iterRunes(input))
+        if (rune >= 0xd800 and rune <= 0xdfff)
+            surrogates = true;
+
     Serde::Array actual;
     for (auto const& state : initialStates) {
         Gc::Heap gc;
@@ -222,7 +231,12 @@ export Res<Result> run(Str inputStr) {
         parser._lexer._state = stringToState(state.asStr());
 
         auto diags = Diag::Collector{};
-        parser.write(input, diags);
+        if (surrogates) {
+            parser.write(input, diags);
+        } else {
+            parser.feed(bytes(input), diags);
+            parser.end(diags);
+        }
 
         actual.pushBack(serializeTokens(collector.collected, doubleEscaped));
     }
@@ -72,11 +72,12 @@ struct DocumentEmit {
 
             _indent();
 
-            auto attributes = element->attributes.iterItems() |
-                              Collect<Vec<Tuple<Dom::QualifiedName, Rc<Dom::Attr>>>>();
+            Vec<Dom::Attribute> attributes;
+            for (auto const& attribute : element->attributes)
+                attributes.pushBack(attribute);
 
             sort(attributes, [](auto const& a, auto const& b) {
-                return a.v0.name <=> b.v0.name;
+                return a.name.name <=> b.name.name;
             });
 
             for (usize i = 0; i < attributes.len(); i++) {
@@ -84,7 +85,7 @@ struct DocumentEmit {
 
                 try$(_emit("| "));
                 try$(_insertIndent());
-                try$(_emit("{}=\"{}\"\n", attribute.v0.name, attribute.v1->value));
+                try$(_emit("{}=\"{}\"\n", attribute.name.name, attribute.value));
             }
 
             for (auto child = element->firstChild(); child; child = child->nextSibling()) {
@@ -106,6 +107,30 @@ struct DocumentEmit {
 };
 
 // https://github.com/html5lib/html5lib-tests/blob/master/tree-construction/README.md
+// Parses `data` with write() when `chunkSize` is zero, with feed() in chunks
+// of `chunkSize` bytes otherwise, and serializes the resulting tree.
+static Res<String> _parse(Str data, usize chunkSize) {
+    Gc::Heap gc;
+    auto dom = Dom::Document::create(gc, Ref::Url(), Ref::Uti::PUBLIC_HTML);
+    Html::HtmlParser parser{gc, dom};
+
+    auto diags = Diag::Collector{};
+
+    if (chunkSize == 0) {
+        parser.write(data, diags);
+    } else {
+        auto input = bytes(data);
+        for (usize i = 0; i < input.len(); i += chunkSize)
+            parser.feed(sub(input, i, min(i + chunkSize, input.len())), diags);
+        parser.end(diags);
+    }
+
+    auto sw = Io::StringWriter{};
+    auto e = DocumentEmit{sw};
+    try$(e.write(*dom));
+    return Ok(sw.take());
+}
+
 export Res<Result> run(Str input) {
     auto r = Io::BufReader{bytes(input)};
     auto w = Io::BufferWriter{};
@@ -166,23 +191,18 @@ export Res<Result> run(Str input) {
         w.clear();
     }
 
-    Gc::Heap gc;
-    auto dom = Dom::Document::create(gc, Ref::Url(), Ref::Uti::PUBLIC_HTML);
-    Html::HtmlParser parser{gc, dom};
-
-    auto diags = Diag::Collector{};
-
-    // NOTE: Partial writes are not very well supported for now so we write in one pass.
-    parser.write(data.str(), diags);
-
-    auto sw = Io::StringWriter{};
-    auto e = DocumentEmit{sw};
-
-    try$(e.write(*dom));
+    // NOTE: The same input goes through write(), which consumes it rune by
+    //       rune, and through feed(), whole and one byte at a time, so the
+    //       text run fast path and the carry over between chunks are held to
+    //       the same trees.
+    Str text = data.str();
+    Serde::Array actual;
+    for (usize chunkSize : {0uz, max(text.len(), 1uz), 1uz})
+        actual.pushBack(try$(_parse(text, chunkSize)));
 
     return Ok(Result{
         .reference = document.str(),
-        .actual = {sw.str()},
+        .actual = actual,
     });
 }
 
@@ -97,13 +97,13 @@ Ui::Child elementStartTag(Dom::Element const& el, bool expanded) {
 
     prose->pushSpan(prose->currentSpanStyle().withColor(Ui::ACCENT400));
 
-    for (auto [k, attr] : el.attributes.iterItems()) {
+    for (auto const& [k, value] : el.attributes) {
         prose->append(" "s);
         prose->append(Io::toStr(k));
         prose->append("=\""s);
 
         prose->pushSpan(prose->currentSpanStyle().withColor(Gfx::AMBER500));
-        prose->append(attr->value);
+        prose->append(value);
         prose->popSpan();
 
         prose->append("\""s);
@@ -0,0 +1,30 @@
+export module Vaev.Engine:async;
+
+import Karm.Core;
+
+namespace Vaev {
+
+// Drives all the tasks concurrently on the event loop and waits for every one
+// of them to settle, so none outlives the state it borrows from the caller.
+// Reports the first error encountered.
+export Async::Task<> joinAllAsync(Vec<Async::Task<>> tasks) {
+    Vec<Async::Future<Res<>>> pending;
+    for (auto& task : tasks) {
+        Async::Promise<Res<>> promise;
+        pending.pushBack(promise.future());
+        Async::detach(std::move(task), [promise](Res<> res) mutable {
+            promise.resolve(std::move(res));
+        });
+    }
+
+    Res<> result = Ok();
+    for (auto& future : pending) {
+        auto res = co_await future;
+        if (result and not res)
+            result = res;
+    }
+
+    co_return result;
+}
+
+} // namespace Vaev
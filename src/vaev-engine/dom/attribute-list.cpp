@@ -0,0 +1,85 @@
+export module Vaev.Engine:dom.attributeList;
+
+import Karm.Core;
+import :dom.names;
+import :dom.node;
+
+using namespace Karm;
+
+namespace Vaev::Dom {
+
+export struct Attribute {
+    QualifiedName name;
+    String value;
+
+    void repr(Io::Emit& e) const {
+        e("({} qualifiedName={} value={:#})\n", NodeType::ATTRIBUTE, name, value);
+    }
+};
+
+// https://dom.spec.whatwg.org/#concept-element-attribute
+// NOTE: Most elements have a handful of attributes, they are stored side by
+//       side in a single vector, in insertion order, and found by comparing
+//       their interned names. A hashed index is only built for elements
+//       with many attributes, behind a pointer, so the others don't pay for
+//       its size.
+export struct AttributeList {
+    static constexpr usize INDEX_THRESHOLD = 16;
+
+    Vec<Attribute> _attributes;
+    Opt<Box<Map<QualifiedName, usize>>> _index;
+
+    usize len() const {
+        return _attributes.len();
+    }
+
+    Attribute const* begin() const {
+        return _attributes.buf();
+    }
+
+    Attribute const* end() const {
+        return _attributes.buf() + _attributes.len();
+    }
+
+    Opt<usize> _indexOf(QualifiedName const& name) const {
+        if (auto& [index] = _index) {
+            if (auto i = index->lookup(name))
+                return *i;
+            return NONE;
+        }
+
+        for (usize i = 0; i < _attributes.len(); i++)
+            if (_attributes[i].name == name)
+                return i;
+        return NONE;
+    }
+
+    bool contains(QualifiedName const& name) const {
+        return _indexOf(name) != NONE;
+    }
+
+    Opt<Str> lookup(QualifiedName const& name) const {
+        if (auto index = _indexOf(name))
+            return _attributes[*index].value.str();
+        return NONE;
+    }
+
+    void put(QualifiedName const& name, String value) {
+        if (auto index = _indexOf(name)) {
+            _attributes[*index].value = std::move(value);
+            return;
+        }
+
+        _attributes.pushBack({name, std::move(value)});
+        if (auto& [index] = _index) {
+            index->put(name, _attributes.len() - 1);
+        } else if (_attributes.len() > INDEX_THRESHOLD) {
+            auto newIndex = makeBox<Map<QualifiedName, usize>>();
+            for (usize i = 0; i < _attributes.len(); i++)
+                newIndex->put(_attributes[i].name, i);
+            _index = std::move(newIndex);
+        }
+    }
+};
+
+} // namespace Vaev::Dom
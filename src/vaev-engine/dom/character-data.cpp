@@ -29,6 +29,12 @@ export struct CharacterData : Node {
         return _data.str();
     }
 
+    // https://dom.spec.whatwg.org/#dom-characterdata-data
+    void setData(Str s) {
+        _data.clear();
+        _data.append(s);
+    }
+
     void getTextContent(StringBuilder& sb) const override {
         sb.append(data());
     }
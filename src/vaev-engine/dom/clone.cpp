@@ -0,0 +1,71 @@
+export module Vaev.Engine:dom.clone;
+
+import Karm.Core;
+import Karm.Gc;
+
+import :dom.comment;
+import :dom.document;
+import :dom.documentType;
+import :dom.element;
+import :dom.node;
+import :dom.text;
+import :style.stylesheet;
+
+using namespace Karm;
+
+namespace Vaev::Dom {
+
+// https://dom.spec.whatwg.org/#concept-node-clone
+export Gc::Ref<Node> cloneNode(Gc::Heap& heap, Node const& node, bool subtree = true) {
+    Gc::Ref<Node> copy = [&] -> Gc::Ref<Node> {
+        if (auto element = node.is<Element>()) {
+            auto elementCopy = heap.alloc<Element>(element->qualifiedName);
+            for (auto const& [name, value] : element->attributes)
+                elementCopy->setAttribute(name, value);
+
+            // NOSPEC: Fetched replaced content is shared with the copy.
+            elementCopy->imageContent = element->imageContent;
+            return elementCopy;
+        }
+
+        if (auto text = node.is<Text>())
+            return heap.alloc<Text>(String{text->data()});
+
+        if (auto comment = node.is<Comment>())
+            return heap.alloc<Comment>(String{comment->data()});
+
+        if (auto doctype = node.is<DocumentType>())
+            return heap.alloc<DocumentType>(doctype->name, doctype->publicId, doctype->systemId);
+
+        panic("unsupported node type");
+    }();
+
+    if (subtree)
+        for (auto child = node.firstChild(); child; child = child->nextSibling())
+            copy->appendChild(cloneNode(heap, *child));
+
+    return copy;
+}
+
+// https://dom.spec.whatwg.org/#concept-node-clone
+// NOSPEC: The copy shares the style sheets, registered properties and font
+//         database of the original document, they are reference counted so
+//         the copy doesn't depend on the heap of the original. The list
+//         itself lives on the heap of the copy.
+export Gc::Ref<Document> cloneDocument(Gc::Heap& heap, Document const& document) {
+    auto styleSheets = heap.alloc<Style::StyleSheetList>(*document.styleSheets);
+    auto copy = heap.alloc<Document>(document.url(), document.contentType(), styleSheets);
+    copy->quirkMode = document.quirkMode;
+    copy->xmlVersion = document.xmlVersion;
+    copy->xmlEncoding = document.xmlEncoding;
+    copy->xmlStandalone = document.xmlStandalone;
+    copy->registeredPropertySet = document.registeredPropertySet;
+    copy->fontDatabase = document.fontDatabase;
+
+    for (auto child = document.firstChild(); child; child = child->nextSibling())
+        copy->appendChild(cloneNode(heap, *child));
+
+    return copy;
+}
+
+} // namespace Vaev::Dom
@@ -2,7 +2,7 @@ export module Vaev.Engine:dom.element;
 
 import Karm.Core;
 import Karm.Scene;
-import :dom.attr;
+import :dom.attributeList;
 import :dom.node;
 import :dom.names;
 import :dom.text;
@@ -66,7 +66,7 @@ export struct Element : Node {
 
     QualifiedName qualifiedName;
     // NOSPEC: Should be a NamedNodeMap
-    Map<QualifiedName, Rc<Attr>> attributes;
+    AttributeList attributes;
     Opt<Rc<Style::ComputedValues>> _computedValues;
     TokenList classList;
     Opt<Rc<Scene::Node>> imageContent;
@@ -87,9 +87,8 @@ export struct Element : Node {
         e(" qualifiedName={}", qualifiedName);
         if (this->attributes.len()) {
             e.indentNewline();
-            for (auto const& [name, attr] : this->attributes.iterItems()) {
-                attr->repr(e);
-            }
+            for (auto const& attribute : this->attributes)
+                attribute.repr(e);
             e.deindent();
         }
     }
@@ -123,7 +122,7 @@ export struct Element : Node {
                 this->classList.add(class_);
             }
         }
-        this->attributes.put(name, makeRc<Attr>(name, value));
+        this->attributes.put(name, std::move(value));
     }
 
     bool hasAttribute(QualifiedName name) const {
@@ -131,7 +130,7 @@ export struct Element : Node {
     }
 
     bool hasAttributeUnqualified(Str name) const {
-        for (auto const& [qualifiedName, _] : this->attributes.iterItems()) {
+        for (auto const& [qualifiedName, _] : this->attributes) {
             if (qualifiedName.name.str() == name) {
                 return true;
             }
@@ -140,16 +139,13 @@ export struct Element : Node {
     }
 
     Opt<Str> getAttribute(QualifiedName name) const {
-        auto attr = this->attributes.lookup(name);
-        if (attr == NONE)
-            return NONE;
-        return (*attr)->value;
+        return this->attributes.lookup(name);
     }
 
     Opt<Str> getAttributeUnqualified(Symbol name) const {
-        for (auto const& [qualifiedName, attr] : this->attributes.iterItems())
+        for (auto const& [qualifiedName, value] : this->attributes)
             if (qualifiedName.name == name)
-                return attr->value;
+                return value.str();
         return NONE;
     }
 
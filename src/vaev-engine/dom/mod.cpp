@@ -1,7 +1,8 @@
 export module Vaev.Engine:dom;
 
-export import :dom.attr;
+export import :dom.attributeList;
 export import :dom.character_data;
+export import :dom.clone;
 export import :dom.comment;
 export import :dom.document;
 export import :dom.documentType;
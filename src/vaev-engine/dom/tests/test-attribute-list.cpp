@@ -0,0 +1,40 @@
+#include <karm/test>
+
+import Vaev.Engine;
+
+using namespace Karm;
+using namespace Karm::Literals;
+
+namespace Vaev::Dom::Tests {
+
+test$("attribute-list-replaces-in-place") {
+    AttributeList attributes;
+    attributes.put(Html::ID_ATTR, "a"s);
+    attributes.put(Html::CLASS_ATTR, "b"s);
+    attributes.put(Html::ID_ATTR, "c"s);
+
+    expectEq$(attributes.len(), 2uz);
+    expect$(attributes.lookup(Html::ID_ATTR) == "c"s);
+    expect$(attributes.begin()->name == Html::ID_ATTR);
+    expectNot$(attributes.contains(Html::HREF_ATTR));
+
+    return Ok();
+}
+
+test$("attribute-list-indexes-many-attributes") {
+    AttributeList attributes;
+    usize count = AttributeList::INDEX_THRESHOLD * 2;
+    for (usize i = 0; i < count; i++)
+        attributes.put({NONE, Symbol::from(Io::format("data-{}", i))}, Io::format("{}", i));
+    attributes.put({NONE, "data-3"_sym}, "three"s);
+
+    expectEq$(attributes.len(), count);
+    expect$(attributes.lookup({NONE, "data-3"_sym}) == "three"s);
+    auto last = Io::format("{}", count - 1);
+    expect$(attributes.lookup({NONE, Symbol::from(Io::format("data-{}", count - 1))}) == last.str());
+    expectNot$(attributes.contains({NONE, "data-x"_sym}));
+
+    return Ok();
+}
+
+} // namespace Vaev::Dom::Tests
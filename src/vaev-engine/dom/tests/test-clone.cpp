@@ -0,0 +1,61 @@
+#include <karm/test>
+
+import Vaev.Engine;
+import Karm.Gc;
+import Karm.Ref;
+import Karm.Diag;
+
+using namespace Karm;
+using namespace Karm::Literals;
+
+namespace Vaev::Dom::Tests {
+
+test$("clone-node-copies-subtree") {
+    Gc::Heap gc;
+    auto dom = Dom::Document::create(gc, Ref::Url(), Ref::Uti::PUBLIC_HTML);
+    Html::HtmlParser parser{gc, dom};
+
+    auto diags = Diag::Collector::ignore();
+    parser.write("<p class=a id=b>hello<!--c--></p>"s, diags);
+
+    auto p = dom->body()->firstChild()->is<Element>();
+    expectNe$(p, nullptr);
+
+    auto copy = cloneNode(gc, *p)->is<Element>();
+    expectNe$(copy, nullptr);
+    expect$(copy != p);
+    expect$(copy->qualifiedName == Html::P_TAG);
+    expect$(copy->getAttribute(Html::ID_ATTR) == "b"s);
+    expect$(copy->classList.contains("a"s));
+    expectNot$(copy->hasParentNode());
+
+    auto text = copy->firstChild()->is<Text>();
+    expectNe$(text, nullptr);
+    expectEq$(text->data(), "hello"s);
+    expect$(text->nextSibling()->is<Comment>());
+
+    auto shallow = cloneNode(gc, *p, false);
+    expectNot$(shallow->hasChildren());
+
+    return Ok();
+}
+
+test$("clone-document-into-another-heap") {
+    Gc::Heap gc;
+    auto dom = Dom::Document::create(gc, Ref::Url(), Ref::Uti::PUBLIC_HTML);
+    Html::HtmlParser parser{gc, dom};
+
+    auto diags = Diag::Collector::ignore();
+    parser.write("<!DOCTYPE html><title>x</title>"s, diags);
+
+    Gc::Heap other;
+    auto copy = cloneDocument(other, *dom);
+    expect$(copy->styleSheets != dom->styleSheets);
+    expectEq$(copy->styleSheets->items.len(), dom->styleSheets->items.len());
+    expect$(copy->firstChild()->is<DocumentType>());
+    expectEq$(copy->title(), "x"s);
+
+    return Ok();
+}
+
+} // namespace Vaev::Dom::Tests
@@ -24,16 +24,17 @@ namespace Vaev::Dom {
 export struct Window {
     mutable Gc::Heap _heap;
     Rc<Http::Client> _client;
+    Loader::Options _options;
     Style::Media _media = Style::Media::defaultMedia();
 
     Gc::Ptr<Document> _document = nullptr;
     Opt<Driver::RenderResult> _render = NONE;
 
-    Window(Rc<Http::Client> client)
-        : _client(client) {}
+    Window(Rc<Http::Client> client, Loader::Options options)
+        : _client(client), _options(options) {}
 
-    static Rc<Window> create(Rc<Http::Client> client = Http::defaultClient()) {
-        return makeRc<Window>(client);
+    static Rc<Window> create(Rc<Http::Client> client = Http::defaultClient(), Loader::Options options = {}) {
+        return makeRc<Window>(client, options);
     }
 
     void changeMedia(Style::Media media) {
@@ -50,7 +51,7 @@ export struct Window {
         if (intent == Ref::Uti::PUBLIC_OPEN) {
             _document = co_trya$(
                 Loader::fetchDocumentAsync(
-                    _heap, *_client, url, ct
+                    _heap, *_client, url, _options, ct
                 )
             );
         } else if (intent == Ref::Uti::PUBLIC_MODIFY) {
@@ -63,6 +64,13 @@ export struct Window {
         co_return Ok();
     }
 
+    // Loads the SVG image at `url`, whose body was already fetched.
+    Async::Task<> loadSvgImageAsync(Ref::Url url, Str body, Async::CancellationToken ct) {
+        _document = co_trya$(Loader::loadSvgImageAsync(_heap, *_client, url, body, _options, ct));
+        invalidateRender();
+        co_return Ok();
+    }
+
     [[clang::coro_wrapper]]
     Async::Task<> refreshAsync(Async::CancellationToken ct) {
         return loadLocationAsync(document()->url(), Ref::Uti::PUBLIC_OPEN, ct);
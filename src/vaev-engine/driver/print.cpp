@@ -15,6 +15,7 @@ import :layout;
 import :values;
 import :dom.document;
 import :css;
+import :perf;
 
 using namespace Karm;
 
@@ -149,6 +150,7 @@ static InsetsAu _resolvePageMargin(Print::Margins marginSetting, Margin const& m
 }
 
 Vec<PageLayoutInfos> collectBreakPointsAndRunningPositions(PaginationContext& context) {
+    Perf::Scope _{"layout-discovery"};
     auto startOfDocument = Layout::Breakpoint::startOfDocument();
     Vec<PageLayoutInfos> pageInfos = {};
 
@@ -210,24 +212,23 @@ Vec<PageLayoutInfos> collectBreakPointsAndRunningPositions(PaginationContext& co
     }
 }
 
-export Yield<Print::Page> print(Gc::Heap& heap, Gc::Ref<Dom::Document> dom, Print::Settings const& settings, Opt<PageDecorator&> decorator) {
-    auto media = Style::Media::forPrint(settings);
-
-    Style::Computer computer{
-        heap,
-        media,
-        dom->registeredPropertySet,
-        *dom->styleSheets,
-        dom->fontDatabase,
-    };
-    computer.build();
-    computer.styleDocument(*dom);
+// Paginates a document with a computer that was already built for its style
+// sheets and Style::Media::forPrint(settings).
+export Yield<Print::Page> print(Gc::Ref<Dom::Document> dom, Style::Computer& computer, Print::Settings const& settings, Opt<PageDecorator&> decorator) {
+    auto& media = computer._media;
+    {
+        Perf::Scope _{"style"};
+        computer.styleDocument(*dom);
+    }
 
     auto initialStyle = dom->initialComputedValues();
 
-    Layout::Tree contentTree = {
-        Layout::buildDocument(dom),
-    };
+    Layout::Tree contentTree = [&] {
+        Perf::Scope _{"layout-build"};
+        return Layout::Tree{
+            Layout::buildDocument(dom),
+        };
+    }();
 
     Layout::RunningPositionMap runningPosition = {};
 
@@ -244,39 +245,50 @@ export Yield<Print::Page> print(Gc::Heap& heap, Gc::Ref<Dom::Document> dom, Prin
     auto pageInfos = collectBreakPointsAndRunningPositions(paginationContext);
 
     for (auto [infos, i] : iter(pageInfos) | Index()) {
-        contentTree.viewport = {
-            .small = infos.pageContent.size(),
-        };
-        auto output = Layout::layoutRoot(
-            contentTree,
-            {
-                .generateFragment = true,
-                .knownSize = {infos.pageContent.width, NONE},
-                .position = infos.pageContent.topStart(),
-                .availableSpace = infos.pageContent.size(),
-                .containingBlock = infos.pageContent.size(),
-                .runningPosition = &paginationContext.runningPosition,
-                .pageNumber = infos.pageNumber,
-                .breakpointTraverser = {
-                    i == 0 ? &startOfDocument : &pageInfos[i - 1].breakpoint,
-                    &infos.breakpoint,
-                },
-            }
-        );
-
         auto pageStack = makeRc<Scene::Stack>();
-        if (settings.headerFooter and settings.margins != Print::MarginOption::NONE)
-            _paintMargins(
-                infos,
-                *pageStack,
-                paginationContext.runningPosition
-            );
-
-        if (auto& [decorator] = paginationContext.decorator)
-            decorator.decorate(paginationContext.media, infos, pageInfos.len(), *pageStack);
+        {
+            Perf::Span _{"page", "{}", infos.pageNumber};
+
+            contentTree.viewport = {
+                .small = infos.pageContent.size(),
+            };
+            auto output = [&] {
+                Perf::Scope _{"layout-fragment"};
+                return Layout::layoutRoot(
+                    contentTree,
+                    {
+                        .generateFragment = true,
+                        .knownSize = {infos.pageContent.width, NONE},
+                        .position = infos.pageContent.topStart(),
+                        .availableSpace = infos.pageContent.size(),
+                        .containingBlock = infos.pageContent.size(),
+                        .runningPosition = &paginationContext.runningPosition,
+                        .pageNumber = infos.pageNumber,
+                        .breakpointTraverser = {
+                            i == 0 ? &startOfDocument : &pageInfos[i - 1].breakpoint,
+                            &infos.breakpoint,
+                        },
+                    }
+                );
+            }();
 
-        Layout::paint(*output.fragment, *pageStack);
-        pageStack->prepare();
+            {
+                Perf::Scope _{"paint"};
+                if (settings.headerFooter and settings.margins != Print::MarginOption::NONE)
+                    _paintMargins(
+                        infos,
+                        *pageStack,
+                        paginationContext.runningPosition
+                    );
+
+                if (auto& [decorator] = paginationContext.decorator)
+                    decorator.decorate(paginationContext.media, infos, pageInfos.len(), *pageStack);
+
+                Layout::paint(*output.fragment, *pageStack);
+                pageStack->prepare();
+            }
+        }
+        Perf::count("pages");
 
         co_yield Print::Page(
             settings.pageSize().cast<f64>(),
@@ -288,4 +300,18 @@ export Yield<Print::Page> print(Gc::Heap& heap, Gc::Ref<Dom::Document> dom, Prin
     }
 }
 
+export Yield<Print::Page> print(Gc::Heap& heap, Gc::Ref<Dom::Document> dom, Print::Settings const& settings, Opt<PageDecorator&> decorator) {
+    Style::Computer computer{
+        heap,
+        Style::Media::forPrint(settings),
+        dom->registeredPropertySet,
+        *dom->styleSheets,
+        dom->fontDatabase,
+    };
+    computer.build();
+
+    for (auto& page : print(dom, computer, settings, decorator))
+        co_yield page;
+}
+
 } // namespace Vaev::Driver
@@ -11,6 +11,7 @@ import :layout;
 import :style;
 import :dom.document;
 import :values;
+import :perf;
 
 namespace Vaev::Driver {
 
@@ -23,36 +24,41 @@ export struct RenderResult {
     Rc<Layout::Fragment> frag;
 };
 
-export RenderResult render(Gc::Heap& heap, Gc::Ref<Dom::Document> dom, Style::Media const& media, Style::Viewport viewport) {
-    Style::Computer computer{
-        heap,
-        media,
-        dom->registeredPropertySet,
-        *dom->styleSheets,
-        dom->fontDatabase,
-    };
-
-    computer.build();
-    computer.styleDocument(*dom);
+// Renders a document with a computer that was already built for its style
+// sheets and media.
+export RenderResult render(Gc::Ref<Dom::Document> dom, Style::Computer& computer, Style::Viewport viewport) {
+    {
+        Perf::Scope _{"style"};
+        computer.styleDocument(*dom);
+    }
 
-    Layout::Tree tree = {
-        Layout::buildDocument(dom),
-        viewport
-    };
+    Layout::Tree tree = [&] {
+        Perf::Scope _{"layout-build"};
+        return Layout::Tree{
+            Layout::buildDocument(dom),
+            viewport
+        };
+    }();
 
-    auto outDiscovery = Layout::layoutRoot(
-        tree,
-        {
-            .generateFragment = true,
-            .knownSize = {viewport.small.width, NONE},
-            .availableSpace = {viewport.small.width, 0_au},
-            .containingBlock = {viewport.small.width, viewport.small.height},
-        }
-    );
+    auto outDiscovery = [&] {
+        Perf::Scope _{"layout-fragment"};
+        return Layout::layoutRoot(
+            tree,
+            {
+                .generateFragment = true,
+                .knownSize = {viewport.small.width, NONE},
+                .availableSpace = {viewport.small.width, 0_au},
+                .containingBlock = {viewport.small.width, viewport.small.height},
+            }
+        );
+    }();
 
     auto sceneRoot = makeRc<Scene::Stack>();
-    Layout::paint(*outDiscovery.fragment, *sceneRoot);
-    sceneRoot->prepare();
+    {
+        Perf::Scope _{"paint"};
+        Layout::paint(*outDiscovery.fragment, *sceneRoot);
+        sceneRoot->prepare();
+    }
 
     if (dumpFragments)
         logDebugIf(dumpFragments, "fragments: {}", *outDiscovery.fragment);
@@ -67,4 +73,17 @@ export RenderResult render(Gc::Heap& heap, Gc::Ref<Dom::Document> dom, Style::Me
     };
 }
 
+export RenderResult render(Gc::Heap& heap, Gc::Ref<Dom::Document> dom, Style::Media const& media, Style::Viewport viewport) {
+    Style::Computer computer{
+        heap,
+        media,
+        dom->registeredPropertySet,
+        *dom->styleSheets,
+        dom->fontDatabase,
+    };
+
+    computer.build();
+    return render(dom, computer, viewport);
+}
+
 } // namespace Vaev::Driver
@@ -30,6 +30,56 @@ struct HtmlEntity {
 #undef ENTITY
 };
 
+// NOTE: ENTITIES is sorted by name, so the names starting with a given prefix
+//       are a contiguous range of it. The range narrows down as the reference
+//       is consumed, like walking down a trie, without scanning the table.
+struct _EntityRange {
+    usize start = 0;
+    usize end = ENTITIES.len();
+
+    // Narrows the range, whose names all share their first `index` bytes, to
+    // the names whose next byte is `rune`.
+    _EntityRange narrow(usize index, Rune rune) const {
+        auto at = [&](usize i) -> isize {
+            auto name = ENTITIES[i].name;
+            return index < name.len() ? static_cast<u8>(name[index]) : -1;
+        };
+
+        usize lo = start, hi = end;
+        while (lo < hi) {
+            usize mid = lo + (hi - lo) / 2;
+            if (at(mid) < static_cast<isize>(rune))
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+
+        usize first = lo;
+        hi = end;
+        while (lo < hi) {
+            usize mid = lo + (hi - lo) / 2;
+            if (at(mid) <= static_cast<isize>(rune))
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+
+        return {first, lo};
+    }
+
+    // The name of length `len` in the range, if any, sorts first.
+    Opt<usize> exact(usize len) const {
+        if (start < end and ENTITIES[start].name.len() == len)
+            return start;
+        return NONE;
+    }
+
+    // Whether a name longer than `len` is in the range.
+    bool partial(usize len) const {
+        return end - start > (exact(len) ? 1 : 0);
+    }
+};
+
 export struct HtmlLexer {
     enum struct State {
 #define STATE(NAME) NAME,
@@ -57,6 +107,8 @@ export struct HtmlLexer {
     bool _inForeignContent = false;
 
     Opt<usize> _matchedCharReferenceNoSemiColon;
+    _EntityRange _entities;
+    usize _matchedEntityNoSemiColon = 0;
 
     HtmlToken& _begin(HtmlToken::Type type, Io::Loc loc) {
         _token = HtmlToken{
@@ -147,6 +199,21 @@ export struct HtmlLexer {
         _sink = &sink;
     }
 
+    // Whether the current state emits ordinary text, without '<', '&', '\r'
+    // or NUL, as is, one character token per rune.
+    bool acceptsRun() const {
+        return _state == State::DATA or
+               _state == State::RCDATA or
+               _state == State::RAWTEXT;
+    }
+
+    // Consumes a run of ordinary text at once, see acceptsRun().
+    void consumeRun(Str run, Io::Loc loc, Diag::Collector& diags) {
+        if (not _sink)
+            panic("no sink");
+        _sink->acceptRun(run, loc, diags);
+    }
+
     void consume(Rune rune, Io::Loc loc, Diag::Collector& diags, bool isEof = false) {
         logDebugIf(debugLexer, "Lexing '{:#c}' {:#x} in {}", rune, rune, _state);
 
@@ -3420,6 +3487,7 @@ export struct HtmlLexer {
             // input character:
             _temp.clear();
             _temp.append('&');
+            _entities = {};
 
             // ASCII alphanumeric
             // Reconsume in the named character reference state.
@@ -3479,36 +3547,21 @@ export struct HtmlLexer {
             //      Eg. given the entities "&not" and "&notinva;", the input "&notinvd" matches "&not" and
             //      flushes "invd" as the return state would
 
-            bool hasPartialMatch = false;
-
-            auto computeMatchState = [&](StringBuilder prefix) {
-                // TODO: (performance) consider sorting entities lexicographically and binary search or using a trie
-
-                prefix.append(rune);
-
-                auto target = prefix.str();
-
-                auto bestMatch = Match::NO;
-                for (auto& entity : ENTITIES) {
-                    auto match = startWith(entity.name, target);
-
-                    if (match == Match::PARTIAL)
-                        hasPartialMatch = true;
-
-                    if (match == Match::YES)
-                        bestMatch = max(bestMatch, match);
-                };
-                return bestMatch;
-            };
-
-            auto matchStateWithNextInputChar = computeMatchState(_temp);
+            auto len = _temp.len();
+            auto candidates = _entities.narrow(len, rune);
+            auto exactMatch = candidates.exact(len + 1);
+            bool hasPartialMatch = candidates.partial(len + 1);
+            auto matchStateWithNextInputChar = exactMatch ? Match::YES : Match::NO;
 
             // NOTE: if rune==';', we are either having Match::YES or Match::NO, not partial
             if (hasPartialMatch) {
                 _temp.append(rune);
+                _entities = candidates;
 
-                if (matchStateWithNextInputChar == Match::YES)
+                if (auto [index] = exactMatch) {
                     _matchedCharReferenceNoSemiColon = _temp.len();
+                    _matchedEntityNoSemiColon = index;
+                }
 
                 break;
             }
@@ -3554,18 +3607,13 @@ export struct HtmlLexer {
                     // to the _temp buffer
 
                     auto _tempWithUnexpandedEntity = _temp.str();
-                    auto entityName = _Str<Utf8>(_tempWithUnexpandedEntity.begin(), _matchedCharReferenceNoSemiColon.unwrap());
-
-                    for (auto& entity : ENTITIES) {
-                        if (entityName == entity.name) {
-                            _temp.clear();
-                            _temp.append(Slice<Rune>::fromNullterminated(entity.runes));
-
-                            for (usize i = _matchedCharReferenceNoSemiColon.unwrap(); i < _tempWithUnexpandedEntity.len(); ++i) {
-                                _temp.append(_tempWithUnexpandedEntity[i]);
-                            }
-                            break;
-                        }
+                    auto& entity = ENTITIES[_matchedEntityNoSemiColon];
+
+                    _temp.clear();
+                    _temp.append(Slice<Rune>::fromNullterminated(entity.runes));
+
+                    for (usize i = _matchedCharReferenceNoSemiColon.unwrap(); i < _tempWithUnexpandedEntity.len(); ++i) {
+                        _temp.append(_tempWithUnexpandedEntity[i]);
                     }
 
                     // Flush code points consumed as a character reference. Switch to
@@ -3604,13 +3652,8 @@ export struct HtmlLexer {
                 // Append one or two characters corresponding to the character reference name (as
                 // given by the second column of the named character references
                 // table) to the temporary buffer.
-                for (auto& entity : ENTITIES) {
-                    if (_temp.str() == entity.name) {
-                        _temp.clear();
-                        _temp.append(Slice<Rune>::fromNullterminated(entity.runes));
-                        break;
-                    }
-                }
+                _temp.clear();
+                _temp.append(Slice<Rune>::fromNullterminated(ENTITIES[exactMatch.unwrap()].runes));
 
                 // Flush code points consumed as a character reference. Switch to
                 // the return state.
@@ -220,7 +220,7 @@ struct _ActiveFormattingElementList {
 
             bool sameAttributes = entries[i].element()->attributes.len() == element->attributes.len();
             if (sameAttributes) {
-                for (auto const& [name, attr] : entries[i].element()->attributes.iterItems()) {
+                for (auto const& [name, value] : entries[i].element()->attributes) {
                     auto other = element->getAttribute(name);
 
                     if (not other) {
@@ -228,7 +228,7 @@ struct _ActiveFormattingElementList {
                         break;
                     }
 
-                    if (attr->value != *other) {
+                    if (value != *other) {
                         sameAttributes = false;
                         break;
                     }
@@ -399,11 +399,22 @@ export struct HtmlParser : HtmlSink {
 
     bool _ignoreNextTokenIfLineFeed = false;
 
+    // Sees every token before tree construction, see bindScanner().
+    HtmlSink* _scanner = nullptr;
+
     HtmlParser(Gc::Heap& heap, Gc::Ref<Dom::Document> document)
         : _heap(heap), _document(document) {
         _lexer.bind(*this);
     }
 
+    // Binds a sink that sees the tokens as they come out of the lexer, like
+    // a speculative parser would, without affecting the tree.
+    void bindScanner(HtmlSink& scanner) {
+        if (_scanner)
+            panic("scanner already bound");
+        _scanner = &scanner;
+    }
+
     // MARK: Algorithm
 
     // https://html.spec.whatwg.org/multipage/parsing.html#current-node
@@ -802,6 +813,26 @@ export struct HtmlParser : HtmlSink {
         return _insertAForeignElement(t, Html::NAMESPACE, false);
     }
 
+    // https://html.spec.whatwg.org/multipage/parsing.html#insert-a-character
+    // NOSPEC: Inserts a run of characters at once, as inserting them one at a
+    //         time would.
+    void _insertCharacters(Str data) {
+        auto location = _apropriatePlaceForInsertingANode();
+
+        if (location.parent->nodeType() == Dom::NodeType::DOCUMENT)
+            return;
+
+        auto previousSibling = location.previousSibling();
+        if (previousSibling and previousSibling->nodeType() == Dom::NodeType::TEXT) {
+            auto text = previousSibling->is<Dom::Text>();
+            text->appendData(data);
+        } else {
+            auto text = _heap.alloc<Dom::Text>(""s);
+            text->appendData(data);
+            location.insert(text);
+        }
+    }
+
     // https://html.spec.whatwg.org/multipage/parsing.html#insert-a-character
     void _insertACharacter(Rune c) {
         // 2. Let the adjusted insertion location be the appropriate place for inserting a node.
@@ -4290,6 +4321,9 @@ export struct HtmlParser : HtmlSink {
 
     // https://html.spec.whatwg.org/multipage/parsing.html#tree-construction
     void accept(HtmlToken& t, Diag::Collector& diags) override {
+        if (_scanner)
+            _scanner->accept(t, diags);
+
         // NOSPEC
         if (_ignoreNextTokenIfLineFeed) {
             _ignoreNextTokenIfLineFeed = false;
@@ -4328,6 +4362,242 @@ export struct HtmlParser : HtmlSink {
         }
     }
 
+    // NOSPEC: A run of ordinary text, in the insertion modes where each of its
+    //         character tokens would be inserted as is, is inserted at once.
+    //         Anything else goes through the character tokens.
+    void acceptRun(Str run, Io::Loc loc, Diag::Collector& diags) override {
+        bool fastPath = not _ignoreNextTokenIfLineFeed and
+                        not _openElements.isEmpty() and
+                        _currentElement()->qualifiedName.ns == Html::NAMESPACE and
+                        (_insertionMode == Mode::IN_BODY or _insertionMode == Mode::TEXT);
+
+        if (not fastPath) {
+            HtmlSink::acceptRun(run, loc, diags);
+            return;
+        }
+
+        if (_scanner)
+            _scanner->acceptRun(run, loc, diags);
+
+        if (_insertionMode == Mode::IN_BODY) {
+            _reconstructActiveFormattingElements();
+            for (auto c : iterRunes(run)) {
+                if (not(c == '\t' or c == '\n' or c == '\f' or c == ' ')) {
+                    _framesetOk = false;
+                    break;
+                }
+            }
+        }
+
+        _insertCharacters(run);
+    }
+
+    // MARK: Streaming
+
+    // State carried from one chunk of the source to the next, see feed().
+    Io::Loc _loc = {};
+    bool _pendingCr = false;
+    Array<u8, 4> _partial = {};
+    usize _partialLen = 0;
+
+    static usize _utf8Len(u8 lead) {
+        if ((lead & 0xe0) == 0xc0)
+            return 2;
+        if ((lead & 0xf0) == 0xe0)
+            return 3;
+        if ((lead & 0xf8) == 0xf0)
+            return 4;
+        // ASCII, or a stray continuation byte decoded as U+FFFD on its own.
+        return 1;
+    }
+
+    // Decodes the rune at the start of `units`, and sets `len` to the number
+    // of units it spans. An invalid sequence decodes to U+FFFD and only spans
+    // the units that were valid so far, the one that broke it starts the next
+    // rune.
+    // https://encoding.spec.whatwg.org/#utf-8-decoder
+    static Rune _utf8Decode(Bytes units, usize& len) {
+        u8 lead = units[0];
+        len = 1;
+        if (lead < 0x80)
+            return lead;
+        if (lead < 0xc2 or lead > 0xf4)
+            return 0xfffd;
+
+        // NOTE: The bounds of the second unit rule out overlong forms,
+        //       surrogates and code points past U+10FFFF.
+        u8 lower = 0x80;
+        u8 upper = 0xbf;
+        if (lead == 0xe0)
+            lower = 0xa0;
+        else if (lead == 0xed)
+            upper = 0x9f;
+        else if (lead == 0xf0)
+            lower = 0x90;
+        else if (lead == 0xf4)
+            upper = 0x8f;
+
+        auto needed = _utf8Len(lead);
+        Rune rune = lead & (0x7f >> needed);
+        for (usize i = 1; i < needed; i++) {
+            if (i >= units.len() or units[i] < lower or units[i] > upper)
+                return 0xfffd;
+            rune = (rune << 6) | (units[i] & 0x3f);
+            lower = 0x80;
+            upper = 0xbf;
+            len++;
+        }
+        return rune;
+    }
+
+    // Length of the run of ordinary text at the start of `units`: valid UTF-8
+    // without '<', '&', '\r' or NUL.
+    static usize _scanTextRun(Bytes units) {
+        static constexpr u64 ONES = 0x0101010101010101;
+        static constexpr u64 HIGHS = 0x8080808080808080;
+
+        auto hasZero = [](u64 v) {
+            return ((v - ONES) & ~v & HIGHS) != 0;
+        };
+
+        auto hasByte = [&](u64 v, u8 b) {
+            return hasZero(v ^ (ONES * b));
+        };
+
+        usize i = 0;
+        while (i < units.len()) {
+            // Eight bytes at a time over plain ASCII text.
+            if (i + 8 <= units.len()) {
+                u64 word = 0;
+                for (usize j = 0; j < 8; j++)
+                    word |= static_cast<u64>(units[i + j]) << (j * 8);
+
+                if (not(word & HIGHS) and
+                    not hasByte(word, '<') and not hasByte(word, '&') and
+                    not hasByte(word, '\r') and not hasZero(word)) {
+                    i += 8;
+                    continue;
+                }
+            }
+
+            u8 lead = units[i];
+            if (lead == '<' or lead == '&' or lead == '\r' or lead == '\0')
+                return i;
+
+            if (lead < 0x80) {
+                i++;
+                continue;
+            }
+
+            // NOTE: Overlong forms, surrogates and out of range code points
+            //       end the run, the rune by rune path decides what they are.
+            auto len = _utf8Len(lead);
+            if (len == 1 or lead < 0xc2 or lead > 0xf4 or i + len > units.len())
+                return i;
+
+            u8 second = units[i + 1];
+            if ((lead == 0xe0 and second < 0xa0) or
+                (lead == 0xed and second > 0x9f) or
+                (lead == 0xf0 and second < 0x90) or
+                (lead == 0xf4 and second > 0x8f))
+                return i;
+
+            for (usize j = 1; j < len; j++)
+                if ((units[i + j] & 0xc0) != 0x80)
+                    return i;
+
+            i += len;
+        }
+        return i;
+    }
+
+    void _advance(Rune r) {
+        if (r == '\n') {
+            _loc.line++;
+            _loc.col = Io::Loc{}.col;
+        } else {
+            _loc.col++;
+        }
+    }
+
+    void _feedRune(Rune r, Diag::Collector& diags) {
+        // https://infra.spec.whatwg.org/#normalize-newlines
+        bool skip = _pendingCr and r == '\n';
+        _pendingCr = r == '\r';
+
+        if (not skip)
+            _lexer.consume(_pendingCr ? '\n' : r, _loc, diags);
+        _advance(r);
+    }
+
+    void _feedUnits(Bytes units, Diag::Collector& diags) {
+        usize i = 0;
+        while (i < units.len()) {
+            // NOTE: A line feed right after a carriage return is dropped by
+            //       _feedRune(), the run can only start past it.
+            if (not _pendingCr and _lexer.acceptsRun()) {
+                auto len = _scanTextRun(sub(units, i, units.len()));
+                if (len) {
+                    auto run = sub(units, i, i + len);
+                    _lexer.consumeRun({reinterpret_cast<char const*>(run.buf()), run.len()}, _loc, diags);
+                    for (auto unit : run) {
+                        // Continuation bytes don't start a new column.
+                        if ((unit & 0xc0) != 0x80)
+                            _advance(unit);
+                    }
+                    i += len;
+                    continue;
+                }
+            }
+
+            usize len = 0;
+            auto rune = _utf8Decode(sub(units, i, units.len()), len);
+            _feedRune(rune, diags);
+            i += len;
+        }
+    }
+
+    // Feeds a chunk of the UTF-8 encoded source as it arrives, a rune or a
+    // "\r\n" split between two chunks is completed by the next one. end()
+    // must be called once the whole source was fed.
+    void feed(Bytes chunk, Diag::Collector& diags) {
+        usize start = 0;
+        if (_partialLen) {
+            auto len = _utf8Len(_partial[0]);
+            while (_partialLen < len and start < chunk.len())
+                _partial[_partialLen++] = chunk[start++];
+            if (_partialLen < len)
+                return;
+            _feedUnits(sub(_partial, 0, _partialLen), diags);
+            _partialLen = 0;
+        }
+
+        // Hold back a rune cut by the end of the chunk.
+        usize end = chunk.len();
+        for (usize i = end; i > start and end - i < 4; i--) {
+            u8 unit = chunk[i - 1];
+            if ((unit & 0xc0) == 0x80)
+                continue;
+            if (i - 1 + _utf8Len(unit) > end) {
+                for (usize j = i - 1; j < end; j++)
+                    _partial[_partialLen++] = chunk[j];
+                end = i - 1;
+            }
+            break;
+        }
+
+        _feedUnits(sub(chunk, start, end), diags);
+    }
+
+    void end(Diag::Collector& diags) {
+        if (_partialLen) {
+            _feedUnits(sub(_partial, 0, _partialLen), diags);
+            _partialLen = 0;
+        }
+        // NOTE: '\3' (End of Text) is used here as a placeholder so we are directed to the EOF case
+        _lexer.consume('\3', _loc, diags, true);
+    }
+
     void write(Str str, Diag::Collector& diags) {
         Io::SScan s{str};
         while (not s.ended()) {
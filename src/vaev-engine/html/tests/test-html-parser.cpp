@@ -560,4 +560,82 @@ test$("parse-misnested-content-in-table") {
     return Ok();
 }
 
+test$("parse-chunked-input") {
+    Gc::Heap gc;
+    auto dom = Dom::Document::create(gc, Ref::Url(), Ref::Uti::PUBLIC_HTML);
+    Html::HtmlParser parser{gc, dom};
+
+    auto diags = Diag::Collector::ignore();
+    // "©" and "\r\n" are split between chunks.
+    parser.feed(bytes("<p>caf\xc3"s), diags);
+    parser.feed(bytes("\xa9\r"s), diags);
+    parser.feed(bytes("\nbar</p>"s), diags);
+    parser.end(diags);
+
+    auto html = dom->firstChild()->is<Element>();
+    auto body = html->lastChild()->is<Element>();
+
+    auto p = body->firstChild()->is<Element>();
+    expectNe$(p, nullptr);
+    expect$(p->qualifiedName == Html::P_TAG);
+
+    auto text = p->firstChild()->is<Text>();
+    expectNe$(text, nullptr);
+    expect$(text->data() == "caf\xc3\xa9\nbar");
+
+    return Ok();
+}
+
+test$("parse-text-runs") {
+    Gc::Heap gc;
+    auto dom = Dom::Document::create(gc, Ref::Url(), Ref::Uti::PUBLIC_HTML);
+    Html::HtmlParser parser{gc, dom};
+
+    auto diags = Diag::Collector::ignore();
+    parser.feed(bytes("<p><b>bold</p><p>still bold, caf\xc3\xa9 &amp; more</p>"s), diags);
+    parser.end(diags);
+
+    auto html = dom->firstChild()->is<Element>();
+    auto body = html->lastChild()->is<Element>();
+
+    auto p = body->lastChild()->is<Element>();
+    expectNe$(p, nullptr);
+    expect$(p->qualifiedName == Html::P_TAG);
+
+    // The formatting element is reconstructed before the run is inserted.
+    auto b = p->firstChild()->is<Element>();
+    expectNe$(b, nullptr);
+    expect$(b->qualifiedName == Html::B_TAG);
+
+    auto text = b->firstChild()->is<Text>();
+    expectNe$(text, nullptr);
+    expect$(text->data() == "still bold, caf\xc3\xa9 & more");
+
+    return Ok();
+}
+
+test$("parse-invalid-utf8") {
+    Gc::Heap gc;
+    auto dom = Dom::Document::create(gc, Ref::Url(), Ref::Uti::PUBLIC_HTML);
+    Html::HtmlParser parser{gc, dom};
+
+    auto diags = Diag::Collector::ignore();
+    // A lead byte followed by ASCII, a truncated sequence and a stray
+    // continuation byte, the bytes after each error are kept.
+    parser.feed(bytes("<p>a\xe2" "bc\xe2\x82" "d\x80" "e</p>"s), diags);
+    parser.end(diags);
+
+    auto html = dom->firstChild()->is<Element>();
+    auto body = html->lastChild()->is<Element>();
+
+    auto p = body->firstChild()->is<Element>();
+    expectNe$(p, nullptr);
+
+    auto text = p->firstChild()->is<Text>();
+    expectNe$(text, nullptr);
+    expect$(text->data() == "a\xef\xbf\xbd" "bc\xef\xbf\xbd" "d\xef\xbf\xbd" "e");
+
+    return Ok();
+}
+
 } // namespace Vaev::Dom::Tests
@@ -80,6 +80,15 @@ export struct HtmlToken {
 export struct HtmlSink {
     virtual ~HtmlSink() = default;
     virtual void accept(HtmlToken& token, Diag::Collector& diags) = 0;
+
+    // A run of text the lexer would have emitted as one character token per
+    // rune, sinks that can handle it at once override this.
+    virtual void acceptRun(Str run, Io::Loc loc, Diag::Collector& diags) {
+        for (auto rune : iterRunes(run)) {
+            HtmlToken token{.type = HtmlToken::CHARACTER, .rune = rune, .span = Io::LocSpan::single(loc)};
+            accept(token, diags);
+        }
+    }
 };
 
 } // namespace Vaev::Html
@@ -18,6 +18,7 @@ import :layout.replaced;
 import :layout.positioned;
 import :layout.table;
 import :layout.values;
+import :perf;
 
 namespace Vaev::Layout {
 
@@ -327,6 +328,7 @@ Input _adaptToContentBox(Input input, UsedSpacings const& usedSpacings) {
 }
 
 Output layoutBorderBox(Tree& tree, Box& box, Input input) {
+    Perf::Span _{"layoutBorderBox", "{}", box.style->display};
     input = _adaptToContentBox(input, input.usedSpacings);
     auto output = layoutContentBox(tree, box, input);
     output.size = output.size + input.usedSpacings.borders.all() + input.usedSpacings.padding.all();
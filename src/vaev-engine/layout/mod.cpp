@@ -11,5 +11,6 @@ export import :layout.layout;
 export import :layout.paint;
 export import :layout.positioned;
 export import :layout.replaced;
+export import :layout.scene;
 export import :layout.table;
 export import :layout.values;
@@ -16,6 +16,7 @@ import :layout.values;
 import :dom.node;
 import :dom.element;
 import :layout.table;
+import :layout.scene;
 
 namespace Vaev::Layout {
 
@@ -313,6 +314,12 @@ static void _paintFrag(Rc<Fragment> frag, Scene::Stack& stack, Opt<UsedBorders>
             auto bound = (*image)->bound();
 
             auto contentBox = boxFragment->contentBox().cast<f64>();
+
+            // NOTE: This is the first stage that knows the size the image is
+            //       used at, lazy images are decoded after it.
+            if (auto sized = (*image).is<SizedNode>())
+                (*sized)->require(contentBox.wh);
+
             auto trans = Math::Trans2f::map(bound, contentBox);
             Rc<Scene::Node> node = makeRc<Scene::Transform>(*image, trans);
 
@@ -0,0 +1,16 @@
+export module Vaev.Engine:layout.scene;
+
+import Karm.Math;
+import Karm.Scene;
+
+namespace Vaev::Layout {
+
+// Replaced content that wants to know the size it is painted at before it
+// is painted, so it can prepare itself at that size.
+export struct SizedNode : Scene::Node {
+    // Called while painting with the size of the content box the node is
+    // mapped to, in CSS pixels, once per use.
+    virtual void require(Math::Vec2f usedSize) = 0;
+};
+
+} // namespace Vaev::Layout
@@ -0,0 +1,347 @@
+export module Vaev.Engine:loader.image;
+
+import Karm.Core;
+import Karm.Gfx;
+import Karm.Image;
+import Karm.Logger;
+import Karm.Math;
+import Karm.Ref;
+import Karm.Scene;
+
+import :layout.scene;
+import :perf;
+
+using namespace Karm::Ref::Literals;
+
+namespace Vaev::Loader {
+
+// MARK: Image Headers ---------------------------------------------------------
+
+export enum struct ImageFormat {
+    PNG,
+    JPEG,
+    GIF,
+    BMP,
+    QOI,
+};
+
+export struct ImageHeader {
+    ImageFormat format;
+    Math::Vec2i size;
+};
+
+static u32 _u16be(Bytes data, usize off) {
+    return (data[off] << 8) | data[off + 1];
+}
+
+static u32 _u32be(Bytes data, usize off) {
+    return (_u16be(data, off) << 16) | _u16be(data, off + 2);
+}
+
+static u32 _u16le(Bytes data, usize off) {
+    return data[off] | (data[off + 1] << 8);
+}
+
+static u32 _u32le(Bytes data, usize off) {
+    return _u16le(data, off) | (_u16le(data, off + 2) << 16);
+}
+
+static bool _startsWith(Bytes data, Str magic) {
+    if (data.len() < magic.len())
+        return false;
+    for (usize i = 0; i < magic.len(); i++)
+        if (data[i] != static_cast<u8>(magic[i]))
+            return false;
+    return true;
+}
+
+// https://www.w3.org/TR/png-3/#11IHDR
+static Opt<ImageHeader> _sniffPng(Bytes data) {
+    if (data.len() < 24 or not _startsWith(data, "\x89PNG\r\n\x1a\n"))
+        return NONE;
+
+    // NOTE: The IHDR chunk must come first, right after the signature and
+    //       the length of the chunk.
+    if (not _startsWith(sub(data, 12, 16), "IHDR"))
+        return NONE;
+
+    return ImageHeader{ImageFormat::PNG, {(isize)_u32be(data, 16), (isize)_u32be(data, 20)}};
+}
+
+// https://www.w3.org/Graphics/JPEG/itu-t81.pdf, B.2.2 Frame header syntax
+static Opt<ImageHeader> _sniffJpeg(Bytes data) {
+    if (data.len() < 4 or data[0] != 0xff or data[1] != 0xd8)
+        return NONE;
+
+    usize off = 2;
+    while (off + 4 <= data.len()) {
+        if (data[off] != 0xff)
+            return NONE;
+
+        u8 marker = data[off + 1];
+        if (marker == 0xff) {
+            // Fill byte
+            off++;
+            continue;
+        }
+
+        // Markers without a segment
+        if (marker == 0x01 or (marker >= 0xd0 and marker <= 0xd7)) {
+            off += 2;
+            continue;
+        }
+
+        bool isFrame = marker >= 0xc0 and marker <= 0xcf and
+                       marker != 0xc4 and marker != 0xc8 and marker != 0xcc;
+        if (isFrame) {
+            if (off + 9 > data.len())
+                return NONE;
+            return ImageHeader{ImageFormat::JPEG, {(isize)_u16be(data, off + 7), (isize)_u16be(data, off + 5)}};
+        }
+
+        off += 2 + _u16be(data, off + 2);
+    }
+
+    return NONE;
+}
+
+// https://www.w3.org/Graphics/GIF/spec-gif89a.txt, 18. Logical Screen Descriptor
+static Opt<ImageHeader> _sniffGif(Bytes data) {
+    if (data.len() < 10 or not(_startsWith(data, "GIF87a") or _startsWith(data, "GIF89a")))
+        return NONE;
+    return ImageHeader{ImageFormat::GIF, {(isize)_u16le(data, 6), (isize)_u16le(data, 8)}};
+}
+
+// https://learn.microsoft.com/en-us/windows/win32/api/wingdi/ns-wingdi-bitmapinfoheader
+static Opt<ImageHeader> _sniffBmp(Bytes data) {
+    if (data.len() < 26 or not _startsWith(data, "BM"))
+        return NONE;
+    // NOTE: The height is negative for top-down bitmaps.
+    auto height = static_cast<i32>(_u32le(data, 22));
+    return ImageHeader{ImageFormat::BMP, {(isize)_u32le(data, 18), (isize)(height < 0 ? -height : height)}};
+}
+
+// https://qoiformat.org/qoi-specification.pdf
+static Opt<ImageHeader> _sniffQoi(Bytes data) {
+    if (data.len() < 14 or not _startsWith(data, "qoif"))
+        return NONE;
+    return ImageHeader{ImageFormat::QOI, {(isize)_u32be(data, 4), (isize)_u32be(data, 8)}};
+}
+
+// Reads the format and the dimensions of an image from its header, without
+// decoding it.
+export Opt<ImageHeader> sniffImageHeader(Bytes data) {
+    Opt<ImageHeader> header = NONE;
+    for (auto sniff : {_sniffPng, _sniffJpeg, _sniffGif, _sniffBmp, _sniffQoi}) {
+        header = sniff(data);
+        if (header)
+            break;
+    }
+
+    if (not header or header->size.x <= 0 or header->size.y <= 0)
+        return NONE;
+    return header;
+}
+
+// MARK: Downsampling ----------------------------------------------------------
+
+// NOTE: Images are only downsampled when it saves a meaningful amount of
+//       pixels, close sizes are better served by the original.
+static constexpr f64 _DOWNSAMPLING_THRESHOLD = 0.8;
+
+// Box filter averaging the source pixels covered by each destination pixel,
+// weighted by their alpha so transparent pixels don't bleed their color.
+// Source rows are read once, in order, and accumulated into a contiguous row
+// of sums.
+static Rc<Gfx::Surface> _downsample(Rc<Gfx::Surface> picture, Math::Vec2i size) {
+    // NOTE: The filter works on raw RGBA8888 rows, pictures decoded to
+    //       another format are converted first.
+    if (not picture->pixels().fmt().is<Gfx::Rgba8888>()) {
+        auto converted = Gfx::Surface::alloc(picture->size(), Gfx::RGBA8888);
+        Gfx::blitUnsafe(converted->mutPixels(), picture->pixels());
+        picture = converted;
+    }
+
+    auto src = picture->pixels();
+    auto srcSize = src.size();
+    auto dst = Gfx::Surface::alloc(size, Gfx::RGBA8888);
+    auto out = dst->mutPixels();
+
+    // The sums each source column goes into, and how many source columns
+    // each destination column covers.
+    Vec<usize> columnOf;
+    columnOf.resize(srcSize.x);
+    Vec<u32> columns;
+    columns.resize(size.x);
+    for (isize sx = 0; sx < srcSize.x; sx++) {
+        usize x = sx * size.x / srcSize.x;
+        columnOf[sx] = x * 4;
+        columns[x]++;
+    }
+
+    Vec<u64> sums;
+    sums.resize(size.x * 4);
+
+    for (isize y = 0; y < size.y; y++) {
+        isize y0 = y * srcSize.y / size.y;
+        isize y1 = max((y + 1) * srcSize.y / size.y, y0 + 1);
+
+        for (auto& sum : sums)
+            sum = 0;
+
+        for (isize sy = y0; sy < y1; sy++) {
+            auto row = src.scanline(sy);
+            for (isize sx = 0; sx < srcSize.x; sx++) {
+                u8 const* c = &row[sx * 4];
+                u64* sum = &sums[columnOf[sx]];
+                u64 alpha = c[3];
+                sum[0] += c[0] * alpha;
+                sum[1] += c[1] * alpha;
+                sum[2] += c[2] * alpha;
+                sum[3] += alpha;
+            }
+        }
+
+        auto row = out.scanline(y);
+        for (isize x = 0; x < size.x; x++) {
+            u64 const* sum = &sums[x * 4];
+            u8* c = &row[x * 4];
+            if (sum[3] == 0) {
+                c[0] = c[1] = c[2] = c[3] = 0;
+                continue;
+            }
+            u64 count = columns[x] * (y1 - y0);
+            c[0] = sum[0] / sum[3];
+            c[1] = sum[1] / sum[3];
+            c[2] = sum[2] / sum[3];
+            c[3] = sum[3] / count;
+        }
+    }
+
+    return dst;
+}
+
+// MARK: Lazy Image ------------------------------------------------------------
+
+// The picture shown in place of an image that could not be loaded or decoded.
+export Rc<Gfx::Surface> missingImage() {
+    return Karm::Image::loadOrFallback("bundle://vaev-engine/missing.qoi"_url).unwrap();
+}
+
+// An image that only knows its dimensions until it is painted for the first
+// time, layout only needs its bound, images that are never painted, on
+// pages that are not printed or in elements that are not displayed, are
+// never decoded.
+export struct LazyImage : Layout::SizedNode {
+    ImageHeader _header;
+    Buf<u8> _data;
+    Opt<Rc<Scene::Image>> _decoded = NONE;
+    Math::Vec2i _decodedSize = {};
+    // Density the image is downsampled for, in dppx, NONE keeps it at its
+    // natural size.
+    Opt<f64> _density;
+    // Largest size the image is painted at, in device pixels.
+    Math::Vec2i _required = {};
+    bool _failed = false;
+
+    LazyImage(ImageHeader header, Buf<u8> data, Opt<f64> density = NONE)
+        : _header(header), _data(std::move(data)), _density(density) {}
+
+    bool downsampledFor(Opt<f64> density) const {
+        if (not _density or not density)
+            return not _density and not density;
+        return *_density == *density;
+    }
+
+    ImageFormat format() const {
+        return _header.format;
+    }
+
+    Math::Rectf bound() override {
+        return {0, 0, static_cast<f64>(_header.size.x), static_cast<f64>(_header.size.y)};
+    }
+
+    // Records that the image is painted at `usedSize` CSS pixels, it is
+    // decoded to the largest of them, in device pixels at its density.
+    void require(Math::Vec2f usedSize) override {
+        if (not _density)
+            return;
+        auto density = _density.unwrap();
+        _required = {
+            max(_required.x, static_cast<isize>(Math::ceil(usedSize.x * density))),
+            max(_required.y, static_cast<isize>(Math::ceil(usedSize.y * density))),
+        };
+    }
+
+    Math::Vec2i _targetSize() const {
+        if (_required.x == 0 or _required.y == 0)
+            return _header.size;
+
+        f64 scale = max(
+            _required.x / static_cast<f64>(_header.size.x),
+            _required.y / static_cast<f64>(_header.size.y)
+        );
+        if (scale >= _DOWNSAMPLING_THRESHOLD)
+            return _header.size;
+
+        return {
+            max(static_cast<isize>(Math::ceil(_header.size.x * scale)), 1),
+            max(static_cast<isize>(Math::ceil(_header.size.y * scale)), 1),
+        };
+    }
+
+    bool failed() const {
+        return _failed;
+    }
+
+    Opt<Rc<Scene::Image>> _decode() {
+        // NOTE: A use larger than what was decoded so far, on a later page or
+        //       in a later document, decodes the image again.
+        auto target = _targetSize();
+        if (_decoded and target.x <= _decodedSize.x and target.y <= _decodedSize.y)
+            return _decoded;
+
+        Perf::Scope _{"image-decode"};
+        auto image = Karm::Image::load(_data);
+        if (not image) {
+            logWarn("failed to decode image: {}", image);
+            _failed = true;
+            _data = {};
+
+            // NOTE: Layout was done with the size of the header, the
+            //       placeholder is scaled to it.
+            _decoded = makeRc<Scene::Image>(bound(), missingImage());
+            _decodedSize = _header.size;
+            return _decoded;
+        }
+
+        auto picture = image.take();
+        if (target != _header.size) {
+            Perf::Scope _{"image-downsample"};
+            picture = _downsample(picture, target);
+        }
+
+        // NOTE: The image is drawn in the bound its header announced, which
+        //       layout was done with.
+        _decoded = makeRc<Scene::Image>(bound(), picture);
+        _decodedSize = target;
+
+        // NOTE: No use can be larger than the natural size, the encoded
+        //       bytes are only kept while they may be decoded again.
+        if (target == _header.size)
+            _data = {};
+
+        return _decoded;
+    }
+
+    void paint(Gfx::Canvas& g, Math::Rectf r, Scene::PaintOptions o) override {
+        if (auto decoded = _decode())
+            (*decoded)->paint(g, r, o);
+    }
+
+    void repr(Io::Emit& e) const override {
+        e("(lazy-image {} {})", _header.size, _failed ? "failed"s : (_decoded ? "decoded"s : "pending"s));
+    }
+};
+
+} // namespace Vaev::Loader
@@ -20,23 +20,79 @@ import :layout.values;
 
 namespace Vaev::Loader {
 
-Async::Task<Rc<Scene::Node>> _fetchImageContentAsync(Http::Client& client, Ref::Url url, Async::CancellationToken ct) {
-    auto resp = co_trya$(client.getAsync(url, ct));
-    if (not resp->body)
-        co_return Error::notFound("could not load image");
+// MARK: Image Cache -----------------------------------------------------------
 
-    auto body = resp->body.unwrap();
+// Decoded images, keyed by their url and a hash of their bytes, so an image
+// repeated across elements, pages and the documents of a batch is decoded
+// once and shares a single picture in memory. Lazy images are only shared
+// between loads downsampling them for the same density.
+struct _CachedImage {
+    Ref::Url url;
+    u64 hash;
+    Rc<Scene::Node> content;
+    usize size;
+};
 
-    auto data = co_trya$(Aio::readAllAsync(*body, ct));
+static constexpr usize _IMAGE_CACHE_BUDGET = 256 * 1024 * 1024;
+
+static Vec<_CachedImage>& _imageCache() {
+    static Vec<_CachedImage> cache;
+    return cache;
+}
+
+static Opt<Rc<Scene::Node>> _lookupImage(Ref::Url const& url, u64 hash, Opt<f64> density) {
+    auto& cache = _imageCache();
+    for (usize i = 0; i < cache.len(); i++) {
+        auto& entry = cache[i];
+        if (entry.url != url or entry.hash != hash)
+            continue;
+
+        // NOTE: Lazy images only fail when painted, after they were cached,
+        //       the next use tries to decode them again.
+        auto lazy = entry.content.is<LazyImage>();
+        if (lazy and (*lazy)->failed()) {
+            cache.removeAt(i);
+            return NONE;
+        }
+        if (lazy and not (*lazy)->downsampledFor(density))
+            continue;
+        return entry.content;
+    }
+    return NONE;
+}
+
+// Bytes an image holds on to, its decoded pixels and, for a lazy image, the
+// encoded bytes it decodes from.
+static usize _imageSize(Rc<Scene::Node> const& content, usize encodedLen) {
+    auto bound = content->bound();
+    auto pixels = static_cast<usize>(bound.width) * static_cast<usize>(bound.height) * 4;
+    if (content.is<LazyImage>())
+        return pixels + encodedLen;
+    if (content.is<Scene::Image>())
+        return pixels;
+
+    // NOTE: SVG images are kept as a scene, their source is a fair estimate
+    //       of its size.
+    return encodedLen;
+}
+
+static void _cacheImage(Ref::Url const& url, u64 hash, Rc<Scene::Node> content, usize size) {
+    auto& cache = _imageCache();
+    if (_makeRoom(cache, size, _IMAGE_CACHE_BUDGET))
+        cache.pushBack({url, hash, content, size});
+}
+
+Async::Task<Rc<Scene::Node>> _decodeImageContentAsync(Http::Client& client, Ref::Url url, Rc<Http::Response> resp, Buf<u8> data, Options options, Async::CancellationToken ct) {
     if (resp->header.contentType().unwrapOr(Ref::sniffBytes(data)).conformsTo(Ref::Uti::PUBLIC_SVG)) {
         auto subClient = makeRc<Http::Client>(client._transport);
         subClient->userAgent = client.userAgent;
-        auto window = Dom::Window::create(subClient);
+        auto window = Dom::Window::create(subClient, options);
 
         // FIXME: Properly determine the size of the SVG
         // https://www.w3.org/TR/SVG2/coords.html#SizingSVGInCSS
         window->changeMedia(Style::Media::forRender({}, Resolution::fromDppx(1)));
-        co_trya$(window->loadLocationAsync(url, Ref::Uti::PUBLIC_OPEN, ct));
+        Str body{reinterpret_cast<char const*>(data.buf()), data.len()};
+        co_trya$(window->loadSvgImageAsync(url, body, ct));
         window->computeStyle();
         auto root = window->document()->documentElement();
         Layout::Resolver resolver;
@@ -49,6 +105,8 @@ Async::Task<Rc<Scene::Node>> _fetchImageContentAsync(Http::Client& client, Ref::
 
         window->changeMedia(Style::Media::forRender({width, height}, Resolution::fromDppx(1)));
         co_return Ok(window->render());
+    } else if (auto header = sniffImageHeader(data)) {
+        co_return Ok(makeRc<LazyImage>(header.take(), std::move(data), options.downsamplingDensity));
     } else {
         auto image = Karm::Image::load(data);
         if (not image)
@@ -57,6 +115,26 @@ Async::Task<Rc<Scene::Node>> _fetchImageContentAsync(Http::Client& client, Ref::
     }
 }
 
+Async::Task<Rc<Scene::Node>> _fetchImageContentAsync(Http::Client& client, Ref::Url url, Options options, Async::CancellationToken ct) {
+    auto resp = co_trya$(client.getAsync(url, ct));
+    if (not resp->body)
+        co_return Error::notFound("could not load image");
+
+    auto body = resp->body.unwrap();
+    auto data = co_trya$(Aio::readAllAsync(*body, ct));
+
+    auto dataHash = hash(bytes(data));
+    if (auto cached = _lookupImage(url, dataHash, options.downsamplingDensity)) {
+        Perf::count("image-cache-hits");
+        co_return Ok(cached.take());
+    }
+
+    auto encodedLen = data.len();
+    auto content = co_trya$(_decodeImageContentAsync(client, url, resp, std::move(data), options, ct));
+    _cacheImage(url, dataHash, content, _imageSize(content, encodedLen));
+    co_return Ok(content);
+}
+
 void _evalFontfaceRules(Style::Rule const& rule, Vec<Style::FontFace>& fontFaces) {
     rule.visit(
         [&](Style::FontFaceRule const& r) {
@@ -70,18 +148,120 @@ void _evalFontfaceRules(Style::Rule const& rule, Vec<Style::FontFace>& fontFaces
     );
 }
 
-Async::Task<Rc<Gfx::Fontface>> _loadFontfaceAsync(Http::Client& client, Ref::Url url, Async::CancellationToken ct) {
-    auto resp = co_trya$(client.getAsync(url, ct));
-    if (not resp->body)
-        co_return Error::notFound("could not load image");
+// MARK: Fontface Cache --------------------------------------------------------
+
+// Loaded fontfaces, keyed by their url and a hash of their bytes, so the
+// documents of a batch using the same web fonts share a single fontface and
+// a single copy of its data.
+struct _CachedFontface {
+    Ref::Url url;
+    u64 hash;
+    Rc<Gfx::Fontface> face;
+    usize size; //< Length of the font data.
+};
+
+static constexpr usize _FONTFACE_CACHE_BUDGET = 64 * 1024 * 1024;
+
+static Vec<_CachedFontface>& _fontfaceCache() {
+    static Vec<_CachedFontface> cache;
+    return cache;
+}
+
+static Opt<Rc<Gfx::Fontface>> _lookupFontface(Ref::Url const& url, u64 hash) {
+    for (auto& entry : _fontfaceCache())
+        if (entry.url == url and entry.hash == hash)
+            return entry.face;
+    return NONE;
+}
+
+static void _cacheFontface(Ref::Url const& url, u64 hash, Rc<Gfx::Fontface> face, usize size) {
+    auto& cache = _fontfaceCache();
+    if (_makeRoom(cache, size, _FONTFACE_CACHE_BUDGET))
+        cache.pushBack({url, hash, face, size});
+}
+
+// NOTE: Local fonts are mapped read-only from their file instead of being
+//       copied, the mapping is backed by the page cache and shared with
+//       every other document and process using the same font.
+static bool _isMappableUrl(Ref::Url const& url) {
+    return url.scheme == "file" or url.scheme == "bundle";
+}
+
+// Maps the file behind a local response. The file is only opened once the
+// client allowed the request, and only used if it still has the length the
+// response announced, a file replaced or truncated in between is read from
+// the response instead.
+static Res<Sys::Mmap> _mapFontData(Ref::Url const& url, usize len) {
+    auto file = try$(Sys::File::open(url));
+    auto mem = try$(Sys::mmap(file));
+    if (mem.bytes().len() != len)
+        return Error::invalidData("font changed while being loaded");
+    return Ok(std::move(mem));
+}
+
+// Reads the body of the response into an anonymous mapping, directly when the
+// length of the body is known upfront.
+static Async::Task<Sys::Mmap> _readFontDataAsync(Rc<Http::Response> resp, Async::CancellationToken ct) {
     auto body = resp->body.unwrap();
+
+    if (auto [len] = resp->header.contentLength()) {
+        auto mem = co_try$(Sys::mutMmap(NONE, {.size = alignUp(len, Sys::pageSize())}));
+        auto buf = mem.mutBytes();
+        usize read = 0;
+        while (read < len) {
+            auto n = co_trya$(body->readAsync(mutSub(buf, read, len), ct));
+            if (n == 0)
+                co_return Error::unexpectedEof("font body is shorter than its content-length");
+            read += n;
+        }
+        co_return Ok(mem.seal());
+    }
+
     auto data = co_trya$(Aio::readAllAsync(*body, ct));
+    if (data.len() == 0)
+        co_return Error::invalidData("font is empty");
 
-    // FIXME: Make this more streamline and avoid the extra copy once we reworked karm-font.
-    auto size = alignUp(data.len(), Sys::pageSize());
-    auto mem = co_try$(Sys::mutMmap(NONE, {.size = size}));
+    auto mem = co_try$(Sys::mutMmap(NONE, {.size = alignUp(data.len(), Sys::pageSize())}));
     copy(sub(data), mem.mutBytes());
-    co_return Font::loadFontface(mem.seal());
+    co_return Ok(mem.seal());
+}
+
+Async::Task<Sys::Mmap> _fetchFontDataAsync(Http::Client& client, Ref::Url url, Async::CancellationToken ct) {
+    // NOTE: Local fonts still go through the client, which enforces what the
+    //       document is allowed to access.
+    auto resp = co_trya$(client.getAsync(url, ct));
+    if (not resp->body)
+        co_return Error::notFound("could not load font");
+
+    if (auto [len] = resp->header.contentLength()) {
+        if (len == 0)
+            co_return Error::invalidData("font is empty");
+
+        if (_isMappableUrl(url)) {
+            auto mem = _mapFontData(url, len);
+            if (mem)
+                co_return mem;
+            logWarn("could not map font {}: {}, reading it instead", url, mem);
+        }
+    }
+
+    co_return co_await _readFontDataAsync(resp, ct);
+}
+
+Async::Task<Rc<Gfx::Fontface>> _loadFontfaceAsync(Http::Client& client, Ref::Url url, Async::CancellationToken ct) {
+    auto mem = co_trya$(_fetchFontDataAsync(client, url, ct));
+
+    auto dataHash = hash(mem.bytes());
+    if (auto cached = _lookupFontface(url, dataHash)) {
+        Perf::count("fontface-cache-hits");
+        co_return Ok(cached.take());
+    }
+
+    Perf::count("fontfaces");
+    auto size = mem.bytes().len();
+    auto face = co_try$(Font::loadFontface(std::move(mem)));
+    _cacheFontface(url, dataHash, face, size);
+    co_return Ok(face);
 }
 
 // Formats the engine cannot decode (no woff/woff2/brotli unwrap, no svg/eot
@@ -102,7 +282,7 @@ Async::_Task<Rc<Font::Database>> _loadFontfacesAsync(Http::Client& client, Dom::
     auto fontDatabase = document.fontDatabase;
     for (auto const& sheet : document.styleSheets->items) {
         Vec<Style::FontFace> fontFaces;
-        for (auto const& rule : sheet.rules)
+        for (auto const& rule : sheet->rules)
             _evalFontfaceRules(rule, fontFaces);
 
         for (auto const& ff : fontFaces) {
@@ -126,9 +306,9 @@ Async::_Task<Rc<Font::Database>> _loadFontfacesAsync(Http::Client& client, Dom::
 
                 auto fontUrl = src.identifier.unwrap<Ref::Url>();
 
-                auto resolvedUrl = Ref::Url::resolveReference(sheet.href, fontUrl);
+                auto resolvedUrl = Ref::Url::resolveReference(sheet->href, fontUrl);
                 if (not resolvedUrl) {
-                    logWarn("Cannot resolve urls when loading fonts: {} {}", ff.family, sheet.href);
+                    logWarn("Cannot resolve urls when loading fonts: {} {}", ff.family, sheet->href);
                     continue;
                 }
 
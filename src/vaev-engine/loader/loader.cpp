@@ -14,8 +14,12 @@ import Karm.Sys;
 import Karm.Logger;
 import Karm.Image;
 
+import :async;
 import :dom.document;
 import :html;
+import :loader.image;
+import :loader.userAgent;
+import :perf;
 import :xml;
 import :style;
 
@@ -37,12 +41,192 @@ static Ref::Uti _determineComputedType(Ref::Url url, Rc<Http::Response> response
     return contentType;
 }
 
+// Settings of a document load, they apply to its subresources as well.
+export struct Options {
+    usize fetchConcurrency = 8; //< Subresources fetched at the same time.
+
+    // Lazily decoded images are downsampled to the largest size they are
+    // painted at, in device pixels at this density in dppx. NONE keeps them
+    // at their natural size.
+    Opt<f64> downsamplingDensity = NONE;
+};
+
+// MARK: Caches ----------------------------------------------------------------
+
+// The loader caches are bounded by the bytes their entries hold on to, each
+// entry records its own size. Evicts the oldest entries of `cache` until an
+// entry of `size` bytes fits in `budget`, returns false if it never can.
+template <typename T>
+bool _makeRoom(Vec<T>& cache, usize size, usize budget) {
+    if (size > budget)
+        return false;
+
+    usize total = size;
+    for (auto const& entry : cache)
+        total += entry.size;
+
+    while (total > budget) {
+        total -= cache[0].size;
+        cache.removeAt(0);
+    }
+    return true;
+}
+
+// MARK: Preloading ------------------------------------------------------------
+
+Async::Task<Rc<Scene::Node>> _fetchImageContentAsync(Http::Client& client, Ref::Url url, Options options, Async::CancellationToken ct);
+
+Async::Task<String> _fetchStylesheetTextAsync(Http::Client& client, Ref::Url url, Async::CancellationToken ct) {
+    auto resp = co_trya$(client.getAsync(url, ct));
+    if (not resp->body)
+        co_return Error::notFound("could not load stylesheet");
+
+    auto respBody = resp->body.unwrap();
+    co_return co_await Aio::readAllTextAsync<Utf8>(*respBody, ct);
+}
+
+template <typename T>
+struct _Preload {
+    Ref::Url url;
+    Async::Future<Res<T>> result;
+    bool taken = false;
+};
+
+// Subresources fetched speculatively while the document is still being
+// parsed, their results are taken by _fetchResourcesAsync() once the tree
+// is complete, anything else is fetched as usual.
+struct _Preloads : Meta::Pinned {
+    Options options;
+    Vec<_Preload<Rc<Scene::Node>>> images;
+    Vec<_Preload<String>> sheets;
+    usize inFlight = 0;
+
+    _Preloads(Options options)
+        : options(options) {}
+
+    template <typename T>
+    void _start(Vec<_Preload<T>>& preloads, Ref::Url url, Async::Task<T> task) {
+        for (auto& p : preloads)
+            if (p.url == url)
+                return;
+
+        Async::Promise<Res<T>> promise;
+        preloads.pushBack({url, promise.future()});
+        inFlight++;
+        Async::detach(std::move(task), [this, promise](Res<T> res) mutable {
+            inFlight--;
+            promise.resolve(std::move(res));
+        });
+    }
+
+    // NOTE: Preloads are capped by the fetch concurrency, the subresources
+    //       past it are fetched after parsing, as they would be otherwise.
+    bool saturated() const {
+        return inFlight >= max(options.fetchConcurrency, 1uz);
+    }
+
+    void preloadImage(Http::Client& client, Ref::Url url, Async::CancellationToken ct) {
+        if (not saturated())
+            _start(images, url, _fetchImageContentAsync(client, url, options, ct));
+    }
+
+    void preloadStylesheet(Http::Client& client, Ref::Url url, Async::CancellationToken ct) {
+        if (not saturated())
+            _start(sheets, url, _fetchStylesheetTextAsync(client, url, ct));
+    }
+
+    template <typename T>
+    static Opt<Async::Future<Res<T>>> _take(Vec<_Preload<T>>& preloads, Ref::Url const& url) {
+        for (auto& p : preloads) {
+            if (p.url == url and not p.taken) {
+                p.taken = true;
+                return std::move(p.result);
+            }
+        }
+        return NONE;
+    }
+
+    Async::Task<Rc<Scene::Node>> imageAsync(Http::Client& client, Ref::Url url, Async::CancellationToken ct) {
+        if (auto result = _take(images, url)) {
+            Perf::count("preload-hits");
+            co_return co_await *result;
+        }
+        co_return co_await _fetchImageContentAsync(client, url, options, ct);
+    }
+
+    Async::Task<String> stylesheetTextAsync(Http::Client& client, Ref::Url url, Async::CancellationToken ct) {
+        if (auto result = _take(sheets, url)) {
+            Perf::count("preload-hits");
+            co_return co_await *result;
+        }
+        co_return co_await _fetchStylesheetTextAsync(client, url, ct);
+    }
+
+    // Waits for the preloads nobody took, so none of them outlives the client
+    // it borrows.
+    Async::Task<> settleAsync() {
+        for (auto& p : images)
+            if (not p.taken)
+                (void)co_await p.result;
+        for (auto& p : sheets)
+            if (not p.taken)
+                (void)co_await p.result;
+        co_return Ok();
+    }
+};
+
+// https://html.spec.whatwg.org/#active-speculative-html-parser
+// Spots the stylesheets and images of the document in its tokens, as they
+// come out of the lexer, and preloads them while the rest of the document is
+// parsed.
+struct _PreloadScanner : Html::HtmlSink {
+    Http::Client& _client;
+    _Preloads& _preloads;
+    Ref::Url _base;
+    Async::CancellationToken _ct;
+
+    _PreloadScanner(Http::Client& client, _Preloads& preloads, Ref::Url base, Async::CancellationToken ct)
+        : _client(client), _preloads(preloads), _base(base), _ct(ct) {}
+
+    static Opt<Str> _attr(Html::HtmlToken const& t, Str name) {
+        for (auto& attr : t.attrs)
+            if (attr.name == name)
+                return attr.value.str();
+        return NONE;
+    }
+
+    void accept(Html::HtmlToken& t, Diag::Collector&) override {
+        if (t.type != Html::HtmlToken::START_TAG)
+            return;
+
+        if (t.name == "base") {
+            if (auto href = _attr(t, "href"))
+                _base = Ref::Url::parse(*href, _base);
+        } else if (t.name == "img") {
+            if (auto src = _attr(t, "src"))
+                _preloads.preloadImage(_client, Ref::Url::parse(*src, _base), _ct);
+        } else if (t.name == "link") {
+            auto href = _attr(t, "href");
+            if (href and _attr(t, "rel") == "stylesheet"s)
+                _preloads.preloadStylesheet(_client, Ref::Url::parse(*href, _base), _ct);
+        }
+    }
+
+    void acceptRun(Str, Io::Loc, Diag::Collector&) override {
+        // Text never refers to subresources.
+    }
+};
+
 // https://html.spec.whatwg.org/#navigate-html
 static Res<Gc::Ref<Dom::Document>> _loadHtmlDocument(Gc::Heap& heap, Ref::Url url, Ref::Uti contentType, Str body) {
     auto dom = Dom::Document::create(heap, url, contentType);
     Html::HtmlParser parser{heap, dom};
     Diag::Collector diags;
-    parser.write(body, diags);
+    {
+        Perf::Scope _{"html-parse"};
+        parser.feed(bytes(body), diags);
+        parser.end(diags);
+    }
     if (diags.any()) {
         Diag::SimpleRenderer render{url};
         render.render(Sys::err(), diags);
@@ -81,15 +265,68 @@ static Res<Gc::Ref<Dom::Document>> _loadMediaDocument(Gc::Heap& heap, Ref::Url u
     return Ok(dom);
 }
 
+// https://mimesniff.spec.whatwg.org/#reading-the-resource-header
+static constexpr usize _RESOURCE_HEADER_LEN = 1445;
+
+// Reads the first bytes of the body, enough to sniff its type from.
+Async::Task<usize> _readResourceHeaderAsync(Aio::Reader& body, MutBytes buf, Async::CancellationToken ct) {
+    usize len = 0;
+    while (len < buf.len()) {
+        auto n = co_trya$(body.readAsync(mutSub(buf, len, buf.len()), ct));
+        if (n == 0)
+            break;
+        len += n;
+    }
+    co_return Ok(len);
+}
+
+// https://html.spec.whatwg.org/#navigate-html
+// Parses the document as its body arrives, instead of waiting for the whole
+// source, so parsing overlaps with I/O and the source is never held in full.
+Async::Task<Gc::Ref<Dom::Document>> _streamHtmlDocumentAsync(Gc::Heap& heap, Http::Client& client, _Preloads& preloads, Ref::Url url, Ref::Uti contentType, Bytes head, Aio::Reader& body, Async::CancellationToken ct) {
+    auto dom = Dom::Document::create(heap, url, contentType);
+    Html::HtmlParser parser{heap, dom};
+    _PreloadScanner scanner{client, preloads, url, ct};
+    parser.bindScanner(scanner);
+    Diag::Collector diags;
+
+    {
+        Perf::Scope _{"html-parse"};
+        parser.feed(head, diags);
+    }
+
+    Array<u8, 16384> chunk;
+    while (true) {
+        auto n = co_trya$(body.readAsync(mutBytes(chunk), ct));
+        if (n == 0)
+            break;
+        Perf::Scope _{"html-parse"};
+        parser.feed(sub(chunk, 0, n), diags);
+    }
+
+    {
+        Perf::Scope _{"html-parse"};
+        parser.end(diags);
+    }
+
+    if (diags.any()) {
+        Diag::SimpleRenderer render{url};
+        render.render(Sys::err(), diags);
+    }
+    co_return Ok(dom);
+}
+
 // https://html.spec.whatwg.org/#populating-a-session-history-entry:navigate-html
-Async::Task<Gc::Ref<Dom::Document>> _loadDocumentAsync(Gc::Heap& heap, Ref::Url url, Rc<Http::Response> resp, Async::CancellationToken ct) {
+Async::Task<Gc::Ref<Dom::Document>> _loadDocumentAsync(Gc::Heap& heap, Http::Client& client, _Preloads& preloads, Ref::Url url, Rc<Http::Response> resp, Async::CancellationToken ct) {
     if (not resp->body)
         co_return Error::invalidInput("response body is missing");
+    auto& reader = **resp->body;
 
-    auto body = co_trya$(Aio::readAllTextAsync<Utf8>(**resp->body, ct));
+    Array<u8, _RESOURCE_HEADER_LEN> head;
+    auto headLen = co_trya$(_readResourceHeaderAsync(reader, mutBytes(head), ct));
 
     // 1. Let type be the computed type of navigationParams's response.
-    auto contentType = _determineComputedType(url, resp, bytes(body));
+    auto contentType = _determineComputedType(url, resp, sub(head, 0, headLen));
 
     // 2. If the user agent has been configured to process resources of the
     //    given type using some mechanism other than rendering the content
@@ -99,10 +336,19 @@ Async::Task<Gc::Ref<Dom::Document>> _loadDocumentAsync(Gc::Heap& heap, Ref::Url
     // an HTML MIME type
     if (contentType.conformsTo(Ref::Uti::PUBLIC_HTML)) {
         // Return the result of loading an HTML document, given navigationParams.
-        co_return _loadHtmlDocument(heap, url, contentType, body);
+        co_return co_await _streamHtmlDocumentAsync(heap, client, preloads, url, contentType, sub(head, 0, headLen), reader, ct);
     }
+
+    // NOSPEC: The other types are loaded from their whole source.
+    Io::BufferWriter source;
+    co_try$(source.write(sub(head, 0, headLen)));
+    auto rest = co_trya$(Aio::readAllAsync(reader, ct));
+    co_try$(source.write(bytes(rest)));
+    auto buf = source.take();
+    Str body{reinterpret_cast<char const*>(buf.buf()), buf.len()};
+
     // an XML MIME type that is not an explicitly supported XML MIME type
-    else if (contentType.conformsTo(Ref::Uti::PUBLIC_XML)) {
+    if (contentType.conformsTo(Ref::Uti::PUBLIC_XML)) {
         // Return the result of loading an XML document given navigationParams and type.
         co_return _loadXmlDocument(heap, url, contentType, body);
     }
@@ -149,17 +395,60 @@ export Async::Task<Gc::Ref<Dom::Document>> viewSourceAsync(Gc::Heap& heap, Http:
     co_return Ok(dom);
 }
 
-Async::Task<Style::StyleSheet> _fetchStylesheetAsync(Http::Client& client, Dom::Document& document, Ref::Url url, Style::Origin origin, Async::CancellationToken ct) {
-    auto resp = co_trya$(client.getAsync(url, ct));
-    if (not resp->body)
-        co_return Error::notFound("could not load stylesheet");
+// MARK: Author Stylesheets ---------------------------------------------------
+
+// Parsed author stylesheets, keyed by their url and a hash of their text, so
+// the documents of a batch sharing a stylesheet only parse it once. Each
+// entry keeps the custom properties the stylesheet refers to, to register
+// them in every document using it.
+struct _CachedStyleSheet {
+    Ref::Url href;
+    u64 hash;
+    Rc<Style::StyleSheet> sheet;
+    Map<Symbol, Rc<Style::Property::Registration>> registrations;
+    usize size; //< Length of the source text, parsed rules grow with it.
+};
+
+static constexpr usize _STYLESHEET_CACHE_BUDGET = 8 * 1024 * 1024;
+
+static Vec<_CachedStyleSheet>& _styleSheetCache() {
+    static Vec<_CachedStyleSheet> cache;
+    return cache;
+}
 
-    auto respBody = resp->body.unwrap();
-    auto buf = co_trya$(Aio::readAllTextAsync<Utf8>(*respBody, ct));
+Rc<Style::StyleSheet> _parseAuthorStylesheet(Dom::Document& document, Ref::Url href, Str text, Diag::Collector& diags) {
+    auto& cache = _styleSheetCache();
+    auto textHash = hash(text);
+
+    for (auto& entry : cache) {
+        if (entry.href == href and entry.hash == textHash) {
+            Perf::count("stylesheet-cache-hits");
+            document.registeredPropertySet.adopt(entry.registrations);
+            return entry.sheet;
+        }
+    }
+
+    Perf::Scope _{"css-parse"};
+    Perf::count("stylesheets");
+    auto& registry = document.registeredPropertySet;
+    registry.openJournal();
+    Io::SScan s{text};
+    auto sheet = makeRc<Style::StyleSheet>(Style::StyleSheet::parse(registry, s, diags, href));
+    auto registrations = registry.closeJournal();
+
+    // NOTE: Outdated versions of a stylesheet are never hit again and age
+    //       out with the oldest entries once the cache is full.
+    if (_makeRoom(cache, text.len(), _STYLESHEET_CACHE_BUDGET))
+        cache.pushBack({href, textHash, sheet, std::move(registrations), text.len()});
+
+    return sheet;
+}
+
+Async::Task<Rc<Style::StyleSheet>> _fetchStylesheetAsync(Http::Client& client, _Preloads& preloads, Dom::Document& document, Ref::Url url, Async::CancellationToken ct) {
+    auto buf = co_trya$(preloads.stylesheetTextAsync(client, url, ct));
 
-    Io::SScan s{buf};
     Diag::Collector diags;
-    auto stylesheet = Style::StyleSheet::parse(document.registeredPropertySet, s, diags, url, origin);
+    auto stylesheet = _parseAuthorStylesheet(document, url, buf, diags);
 
     if (diags.any()) {
         Diag::SimpleRenderer render{url};
@@ -169,76 +458,185 @@ Async::Task<Style::StyleSheet> _fetchStylesheetAsync(Http::Client& client, Dom::
     co_return Ok(stylesheet);
 }
 
-Async::Task<Rc<Scene::Node>> _fetchImageContentAsync(Http::Client& client, Ref::Url url, Async::CancellationToken ct);
-
 Rc<Scene::Node> _missingImagePlaceholder() {
-    auto placeholder = Karm::Image::loadOrFallback("bundle://vaev-engine/missing.qoi"_url).unwrap();
+    auto placeholder = missingImage();
     return makeRc<Scene::Image>(placeholder->bound().cast<f64>(), placeholder);
 }
 
-Async::Task<> _fetchResourcesAsync(Http::Client& client, Dom::Document& document, Gc::Ref<Dom::Node> node, Async::CancellationToken ct) {
+Async::Task<> _fetchImageAsync(Http::Client& client, _Preloads& preloads, Gc::Ref<Dom::Element> el, Async::CancellationToken ct) {
+    auto src = el->getAttribute(Html::SRC_ATTR);
+    if (not src) {
+        el->imageContent = _missingImagePlaceholder();
+        logWarn("image element missing src attribute");
+        co_return Error::invalidInput("link element missing src");
+    }
+
+    auto url = Ref::Url::parse(*src, el->baseURI());
+    Perf::AsyncSpan _{"fetchImage", "{}", url};
+    Perf::count("images");
+    auto image = co_await preloads.imageAsync(client, url, ct);
+    if (not image) {
+        el->imageContent = _missingImagePlaceholder();
+        logWarn("failed to fetch image from {}: {}", url, image);
+        co_return Error::invalidInput("failed to fetch image");
+    }
+
+    el->imageContent = image.take();
+    co_return Ok();
+}
+
+// Fetches the content of an <img> element from its current src attribute.
+export Async::Task<> fetchImageAsync(Http::Client& client, Gc::Ref<Dom::Element> el, Options options, Async::CancellationToken ct) {
+    _Preloads none{options};
+    co_return co_await _fetchImageAsync(client, none, el, ct);
+}
+
+// A subresource of the document, in document order.
+struct _Subresource {
+    Gc::Ref<Dom::Element> el;
+    // Slot of the stylesheet for <link rel=stylesheet>, images have none.
+    Opt<usize> sheet = NONE;
+    // Other <img> elements with the same src, they share the fetched image.
+    Vec<Gc::Ref<Dom::Element>> sharing = {};
+};
+
+struct _PendingResources {
+    Vec<_Subresource> subresources;
+    // Index of the subresource fetching each image src.
+    Map<Str, usize> images;
+    // Author stylesheets in document order, filled in as they are fetched.
+    Vec<Opt<Rc<Style::StyleSheet>>> sheets;
+};
+
+void _collectResources(Dom::Document& document, Gc::Ref<Dom::Node> node, _PendingResources& pending) {
     auto el = node->is<Dom::Element>();
     if (el and el->qualifiedName == Html::IMG_TAG) {
         auto src = el->getAttribute(Html::SRC_ATTR);
         if (not src) {
-            el->imageContent = _missingImagePlaceholder();
-            logWarn("image element missing src attribute");
-            co_return Error::invalidInput("link element missing src");
+            pending.subresources.pushBack({el.upgrade()});
+        } else if (auto index = pending.images.lookup(*src)) {
+            pending.subresources[*index].sharing.pushBack(el.upgrade());
+        } else {
+            pending.images.put(*src, pending.subresources.len());
+            pending.subresources.pushBack({el.upgrade()});
         }
-
-        auto url = Ref::Url::parse(*src, node->baseURI());
-        auto image = co_await _fetchImageContentAsync(client, url, ct);
-        if (not image) {
-            el->imageContent = _missingImagePlaceholder();
-            logWarn("failed to fetch image from {}: {}", url, image);
-            co_return Error::invalidInput("failed to fetch image");
-        }
-
-        el->imageContent = image.take();
     } else if (el and el->qualifiedName == Html::STYLE_TAG) {
         auto text = el->textContent();
-        Io::SScan textScan{text};
         Diag::Collector diags;
-        auto sheet = Style::StyleSheet::parse(document.registeredPropertySet, textScan, diags, node->baseURI());
+        auto sheet = _parseAuthorStylesheet(document, node->baseURI(), text, diags);
         if (diags.any()) {
             Diag::SimpleRenderer render{Io::format("{}:<style>", node->baseURI())};
             render.render(Sys::err(), diags);
         }
-        document.styleSheets->add(std::move(sheet));
+        pending.sheets.pushBack(std::move(sheet));
     } else if (el and el->qualifiedName == Html::LINK_TAG) {
         auto rel = el->getAttribute(Html::REL_ATTR);
         if (rel == "stylesheet"s) {
-            auto href = el->getAttribute(Html::HREF_ATTR);
-            if (not href) {
-                logWarn("link element missing href attribute");
-                co_return Error::invalidInput("link element missing href");
-            }
+            pending.subresources.pushBack({el.upgrade(), pending.sheets.len()});
+            pending.sheets.pushBack(NONE);
+        }
+    } else {
+        for (auto child = node->firstChild(); child; child = child->nextSibling())
+            _collectResources(document, *child, pending);
+    }
+}
 
-            auto url = Ref::Url::parse(*href, node->baseURI());
-            auto sheet = co_await _fetchStylesheetAsync(client, document, url, Style::Origin::AUTHOR, ct);
+Async::Task<Rc<Style::StyleSheet>> _fetchLinkedStylesheetAsync(Http::Client& client, _Preloads& preloads, Dom::Document& document, Gc::Ref<Dom::Element> el, Async::CancellationToken ct) {
+    auto href = el->getAttribute(Html::HREF_ATTR);
+    if (not href) {
+        logWarn("link element missing href attribute");
+        co_return Error::invalidInput("link element missing href");
+    }
 
-            if (not sheet) {
-                logWarn("failed to fetch stylesheet from {}: {}", url, sheet);
-                co_return Error::invalidInput("failed to fetch stylesheet");
-            }
+    auto url = Ref::Url::parse(*href, el->baseURI());
+    Perf::AsyncSpan _{"fetchStylesheet", "{}", url};
+    auto sheet = co_await _fetchStylesheetAsync(client, preloads, document, url, ct);
 
-            document.styleSheets->add(sheet.take());
+    if (not sheet) {
+        logWarn("failed to fetch stylesheet from {}: {}", url, sheet);
+        co_return Error::invalidInput("failed to fetch stylesheet");
+    }
+
+    co_return sheet;
+}
+
+Async::Task<> _fetchWorkerAsync(Http::Client& client, _Preloads& preloads, Dom::Document& document, _PendingResources& pending, usize& next, Async::CancellationToken ct) {
+    while (next < pending.subresources.len()) {
+        auto& subresource = pending.subresources[next++];
+        if (auto [slot] = subresource.sheet) {
+            auto sheet = co_await _fetchLinkedStylesheetAsync(client, preloads, document, subresource.el, ct);
+            if (sheet)
+                pending.sheets[slot] = sheet.take();
+        } else {
+            (void)co_await _fetchImageAsync(client, preloads, subresource.el, ct);
+            for (auto& el : subresource.sharing)
+                el->imageContent = subresource.el->imageContent;
         }
-    } else {
-        for (auto child = node->firstChild(); child; child = child->nextSibling())
-            (void)co_await _fetchResourcesAsync(client, document, *child, ct);
     }
 
     co_return Ok();
 }
 
+// Fetches the images and stylesheets of the document, up to
+// Options::fetchConcurrency at the same time. Failed subresources are reported and
+// skipped, author stylesheets are added in document order regardless of the
+// order their fetches complete in.
+Async::Task<> _fetchResourcesAsync(Http::Client& client, _Preloads& preloads, Dom::Document& document, Async::CancellationToken ct) {
+    _PendingResources pending;
+    _collectResources(document, document, pending);
+
+    usize next = 0;
+    auto workers = min(max(preloads.options.fetchConcurrency, 1uz), pending.subresources.len());
+    Vec<Async::Task<>> tasks;
+    for (usize i = 0; i < workers; i++)
+        tasks.pushBack(_fetchWorkerAsync(client, preloads, document, pending, next, ct));
+    co_trya$(joinAllAsync(std::move(tasks)));
+
+    for (auto& sheet : pending.sheets)
+        if (sheet)
+            document.styleSheets->add(sheet.take());
+
+    co_return Ok();
+}
+
 Async::_Task<Rc<Font::Database>> _loadFontfacesAsync(Http::Client& client, Dom::Document const& document, Async::CancellationToken ct);
 
+static bool _hasForeignObject(Gc::Ref<Dom::Node> node) {
+    auto el = node->is<Dom::Element>();
+    if (el and el->qualifiedName == Svg::FOREIGN_OBJECT_TAG)
+        return true;
+    for (auto child = node->firstChild(); child; child = child->nextSibling())
+        if (_hasForeignObject(*child))
+            return true;
+    return false;
+}
+
+// Loads an SVG image from its already fetched body, without going through
+// fetchDocumentAsync(). Only the SVG user agent stylesheet applies to it, the
+// HTML ones are only needed for the content of <foreignObject>.
+export Async::Task<Gc::Ref<Dom::Document>> loadSvgImageAsync(Gc::Heap& heap, Http::Client& client, Ref::Url url, Str body, Options options, Async::CancellationToken ct) {
+    Gc::Ref<Dom::Document> document = co_try$(_loadXmlDocument(heap, url, Ref::Uti::PUBLIC_SVG, body));
+
+    if (_hasForeignObject(*document)) {
+        document->styleSheets->add(userAgentStyleSheet(UserAgentStyleSheet::HTML));
+        document->styleSheets->add(userAgentStyleSheet(UserAgentStyleSheet::COUNTERS));
+    }
+    document->styleSheets->add(userAgentStyleSheet(UserAgentStyleSheet::SVG));
+    adoptUserAgentRegistrations(document->registeredPropertySet);
+
+    _Preloads none{options};
+    (void)co_await _fetchResourcesAsync(client, none, *document, ct);
+    (void)co_await _loadFontfacesAsync(client, *document, ct);
+
+    co_return Ok(document);
+}
+
 static auto dumpDom = Debug::Flag::debug("web-dom", "Dump the loaded DOM tree");
 static auto dumpStylesheets = Debug::Flag::debug("web-stylesheets", "Dump the loaded stylesheets");
 
 // https://fetch.spec.whatwg.org/#scheme-fetch
-export Async::Task<Gc::Ref<Dom::Document>> fetchDocumentAsync(Gc::Heap& heap, Http::Client& client, Ref::Url const& url, Async::CancellationToken ct) {
+export Async::Task<Gc::Ref<Dom::Document>> fetchDocumentAsync(Gc::Heap& heap, Http::Client& client, Ref::Url const& url, Options options, Async::CancellationToken ct) {
+    Perf::AsyncScope _{"fetch"};
     Ref::Url resolvedUrl = url;
 
     // If request’s current URL’s path is the string "blank",
@@ -250,35 +648,33 @@ export Async::Task<Gc::Ref<Dom::Document>> fetchDocumentAsync(Gc::Heap& heap, Ht
     }
 
     auto response = co_trya$(client.getAsync(resolvedUrl, ct));
-    auto document = co_trya$(_loadDocumentAsync(heap, url, response, ct));
 
-    document->styleSheets->add((co_await _fetchStylesheetAsync(client, *document, "bundle://vaev-engine/html.css"_url, Style::Origin::USER_AGENT, ct))
-                                   .take("user agent stylesheet not available"));
+    _Preloads preloads{options};
+    auto loaded = co_await _loadDocumentAsync(heap, client, preloads, url, response, ct);
+    if (not loaded) {
+        (void)co_await preloads.settleAsync();
+        co_return loaded.none();
+    }
+    auto document = loaded.take();
 
-    document->styleSheets->add((co_await _fetchStylesheetAsync(client, *document, "bundle://vaev-engine/counters.css"_url, Style::Origin::USER_AGENT, ct))
-                                   .take("user agent stylesheet not available"));
+    document->styleSheets->add(userAgentStyleSheet(UserAgentStyleSheet::HTML));
+    document->styleSheets->add(userAgentStyleSheet(UserAgentStyleSheet::COUNTERS));
 
     if (document->quirkMode == Dom::QuirkMode::YES) {
         logWarn("quirky document, using quirky stylesheet");
-        document->styleSheets->add((co_await _fetchStylesheetAsync(client, *document, "bundle://vaev-engine/html-quirk.css"_url, Style::Origin::USER_AGENT, ct))
-                                       .take("user agent stylesheet not available"));
+        document->styleSheets->add(userAgentStyleSheet(UserAgentStyleSheet::HTML_QUIRK));
     }
 
-    if (document->contentType() == Ref::Uti::PUBLIC_MARKDOWN) {
-        document->styleSheets->add((co_await _fetchStylesheetAsync(client, *document, "bundle://vaev-engine/markdown.css"_url, Style::Origin::USER_AGENT, ct))
-                                       .take("user agent stylesheet not available"));
-    }
-
-    document->styleSheets->add((co_await _fetchStylesheetAsync(client, *document, "bundle://vaev-engine/print.css"_url, Style::Origin::USER_AGENT, ct))
-                                   .take("user agent stylesheet not available"));
-
-    document->styleSheets->add((co_await _fetchStylesheetAsync(client, *document, "bundle://vaev-engine/svg.css"_url, Style::Origin::USER_AGENT, ct))
-                                   .take("user agent stylesheet not available"));
+    if (document->contentType() == Ref::Uti::PUBLIC_MARKDOWN)
+        document->styleSheets->add(userAgentStyleSheet(UserAgentStyleSheet::MARKDOWN));
 
-    document->styleSheets->add((co_await _fetchStylesheetAsync(client, *document, "bundle://vaev-engine/math.css"_url, Style::Origin::USER_AGENT, ct))
-                                   .take("user agent stylesheet not available"));
+    document->styleSheets->add(userAgentStyleSheet(UserAgentStyleSheet::PRINT));
+    document->styleSheets->add(userAgentStyleSheet(UserAgentStyleSheet::SVG));
+    document->styleSheets->add(userAgentStyleSheet(UserAgentStyleSheet::MATH));
+    adoptUserAgentRegistrations(document->registeredPropertySet);
 
-    (void)co_await _fetchResourcesAsync(client, *document, document, ct);
+    (void)co_await _fetchResourcesAsync(client, preloads, *document, ct);
+    (void)co_await preloads.settleAsync();
     (void)co_await _loadFontfacesAsync(client, *document, ct);
 
     if (dumpDom)
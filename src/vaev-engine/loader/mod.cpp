@@ -1,3 +1,5 @@
 export module Vaev.Engine:loader;
 
+export import :loader.image;
 export import :loader.loader;
+export import :loader.userAgent;
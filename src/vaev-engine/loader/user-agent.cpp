@@ -0,0 +1,95 @@
+export module Vaev.Engine:loader.userAgent;
+
+import Karm.Core;
+import Karm.Diag;
+import Karm.Ref;
+import Karm.Sys;
+
+import :style;
+
+using namespace Karm::Ref::Literals;
+
+namespace Vaev::Loader {
+
+// NOTE: The user agent stylesheets are read straight from the bundle, they
+//       need neither the http client nor an event loop, and they are parsed
+//       once per process, against a registry of their own, then shared by
+//       every document.
+
+export enum struct UserAgentStyleSheet {
+    HTML,
+    HTML_QUIRK,
+    COUNTERS,
+    MARKDOWN,
+    PRINT,
+    SVG,
+    MATH,
+
+    _LEN,
+};
+
+static Ref::Url _userAgentUrl(UserAgentStyleSheet sheet) {
+    switch (sheet) {
+    case UserAgentStyleSheet::HTML:
+        return "bundle://vaev-engine/html.css"_url;
+    case UserAgentStyleSheet::HTML_QUIRK:
+        return "bundle://vaev-engine/html-quirk.css"_url;
+    case UserAgentStyleSheet::COUNTERS:
+        return "bundle://vaev-engine/counters.css"_url;
+    case UserAgentStyleSheet::MARKDOWN:
+        return "bundle://vaev-engine/markdown.css"_url;
+    case UserAgentStyleSheet::PRINT:
+        return "bundle://vaev-engine/print.css"_url;
+    case UserAgentStyleSheet::SVG:
+        return "bundle://vaev-engine/svg.css"_url;
+    case UserAgentStyleSheet::MATH:
+        return "bundle://vaev-engine/math.css"_url;
+    default:
+        unreachable();
+    }
+}
+
+struct _UserAgentStyleSheets {
+    Style::RegisteredPropertySet registry = Style::defaultRegistry();
+    Map<Symbol, Rc<Style::Property::Registration>> registrations = {};
+    Array<Opt<Rc<Style::StyleSheet>>, toUnderlyingType(UserAgentStyleSheet::_LEN)> sheets = {};
+};
+
+static _UserAgentStyleSheets& _userAgentStyleSheets() {
+    static _UserAgentStyleSheets cache;
+    return cache;
+}
+
+export Rc<Style::StyleSheet> userAgentStyleSheet(UserAgentStyleSheet which) {
+    auto& cache = _userAgentStyleSheets();
+    auto& slot = cache.sheets[toUnderlyingType(which)];
+    if (slot)
+        return *slot;
+
+    auto href = _userAgentUrl(which);
+    auto text = Sys::readAllText<Utf8>(href).take("user agent stylesheet not available");
+    Io::SScan s{text};
+    Diag::Collector diags;
+    cache.registry.openJournal();
+    auto sheet = makeRc<Style::StyleSheet>(
+        Style::StyleSheet::parse(cache.registry, s, diags, href, Style::Origin::USER_AGENT)
+    );
+    for (auto const& [propertyName, registration] : cache.registry.closeJournal().iterItems())
+        cache.registrations.put(propertyName, registration);
+
+    if (diags.any()) {
+        Diag::SimpleRenderer render{href};
+        render.render(Sys::err(), diags);
+    }
+
+    slot = sheet;
+    return sheet;
+}
+
+// Custom properties used by the user agent stylesheets are registered while
+// parsing them, the document registry must know about them too.
+export void adoptUserAgentRegistrations(Style::RegisteredPropertySet& registry) {
+    registry.adopt(_userAgentStyleSheets().registrations);
+}
+
+} // namespace Vaev::Loader
@@ -1,11 +1,13 @@
 export module Vaev.Engine;
 
+export import :async;
 export import :css;
 export import :dom;
 export import :driver;
 export import :html;
 export import :layout;
 export import :loader;
+export import :perf;
 export import :props;
 export import :style;
 export import :values;
@@ -0,0 +1,261 @@
+export module Vaev.Engine:perf;
+
+import Karm.Core;
+import Karm.Debug;
+import Karm.Logger;
+import Karm.Sys;
+
+namespace Vaev::Perf {
+
+// Wall time, call and allocation counts of the named pipeline phases,
+// free-form counters, and a trace of nested spans. Everything is a no-op until it is
+// turned on, so the instrumentation can stay in the hot paths.
+
+static auto debugTrace = Debug::Flag::debug("web-trace"s, "Log the spans of the render pipeline"s);
+
+export struct Phase {
+    Str name;
+    usize calls = 0;
+    u64 usecs = 0;
+    usize allocations = 0;
+};
+
+// https://docs.google.com/document/d/1CvAClvFfyA5R-PhYUmn5OOQtYMH4h6I0nSsKchNAySU
+struct _Event {
+    Str name;
+    String detail;
+    u64 ts;
+    u64 dur;
+    Opt<usize> id = NONE; //< Set for async spans.
+};
+
+struct _Registry {
+    bool enabled = false;
+    Vec<Phase> phases;
+    Vec<Pair<Str, usize>> counters;
+
+    bool recording = false;
+    Instant origin = {};
+    Vec<_Event> events;
+    usize nextId = 0;
+
+    Phase& phase(Str name) {
+        for (auto& p : phases)
+            if (p.name == name)
+                return p;
+        phases.pushBack({name});
+        return last(phases);
+    }
+
+    usize& counter(Str name) {
+        for (auto& c : counters)
+            if (c.v0 == name)
+                return c.v1;
+        counters.pushBack({name, 0});
+        return last(counters).v1;
+    }
+};
+
+_Registry& _registry() {
+    static _Registry registry;
+    return registry;
+}
+
+export void enable() {
+    _registry().enabled = true;
+    _countingAllocations = true;
+}
+
+export bool enabled() {
+    return _registry().enabled;
+}
+
+// Starts recording spans for trace().
+export void startTrace() {
+    _registry().recording = true;
+    _registry().origin = Sys::instant();
+}
+
+export bool tracing() {
+    return _registry().recording or debugTrace;
+}
+
+export void reset() {
+    _registry().phases.clear();
+    _registry().counters.clear();
+    _registry().events.clear();
+}
+
+// MARK: Allocations -----------------------------------------------------------
+
+// NOTE: Plain globals rather than part of the registry, they are touched
+//       from operator new, which must not allocate or run initializers.
+bool _countingAllocations = false;
+thread_local usize _allocations = 0;
+
+// Called by the executable's replacement of the global operator new, see
+// src/main.cpp. Only counts while the timings are enabled.
+export void countAllocation() {
+    if (_countingAllocations)
+        _allocations++;
+}
+
+export void count(Str name, usize n = 1) {
+    if (not enabled())
+        return;
+    _registry().counter(name) += n;
+}
+
+// A span of the trace, the name must be a literal since it is kept around
+// until the trace is written. The detail is only formatted while tracing.
+export struct Span : Meta::Pinned {
+    Str _name;
+    String _detail;
+    Opt<Instant> _start;
+    bool _async = false;
+
+    Span(Str name) : _name(name) {
+        if (tracing())
+            _start = Sys::instant();
+    }
+
+    template <typename... Args>
+    Span(Str name, Str format, Args&&... args) : _name(name) {
+        if (not tracing())
+            return;
+        _detail = Io::format(format, std::forward<Args>(args)...);
+        _start = Sys::instant();
+    }
+
+    ~Span() {
+        if (not _start)
+            return;
+
+        auto& registry = _registry();
+        auto start = _start.unwrap();
+        auto dur = (Sys::instant() - start).toUSecs();
+
+        if (debugTrace)
+            logDebugIf(debugTrace, "{} {} {}us", _name, _detail, dur);
+
+        if (registry.recording)
+            registry.events.pushBack({
+                _name,
+                std::move(_detail),
+                (start - registry.origin).toUSecs(),
+                dur,
+                _async ? Opt<usize>{registry.nextId++} : NONE,
+            });
+    }
+};
+
+// A span held across suspension points. Other tasks run while it is open,
+// so it overlaps the spans around it without nesting in them, and is
+// recorded on a track of its own.
+export struct AsyncSpan : Span {
+    AsyncSpan(Str name) : Span(name) {
+        _async = true;
+    }
+
+    template <typename... Args>
+    AsyncSpan(Str name, Str format, Args&&... args)
+        : Span(name, format, std::forward<Args>(args)...) {
+        _async = true;
+    }
+};
+
+template <typename S>
+struct _Scope : Meta::Pinned {
+    S _span;
+    Opt<Instant> _start;
+    usize _allocations = 0;
+
+    _Scope(Str name) : _span(name) {
+        if (not enabled())
+            return;
+        _start = Sys::instant();
+        _allocations = Perf::_allocations;
+    }
+
+    ~_Scope() {
+        if (not _start)
+            return;
+        auto& phase = _registry().phase(_span._name);
+        phase.calls++;
+        phase.usecs += (Sys::instant() - _start.unwrap()).toUSecs();
+        phase.allocations += Perf::_allocations - _allocations;
+    }
+};
+
+// Accounts the lifetime of the scope to the phase `name`, and records it as
+// a span of the trace.
+export using Scope = _Scope<Span>;
+
+// Same as Scope, for a phase held across suspension points, see AsyncSpan.
+export using AsyncScope = _Scope<AsyncSpan>;
+
+export Serde::Value report() {
+    Serde::Array phases;
+    for (auto& p : _registry().phases) {
+        Serde::Object phase;
+        phase.put("name"s, String{p.name});
+        phase.put("calls"s, p.calls);
+        phase.put("ms"s, p.usecs / 1000.0);
+        phase.put("allocations"s, p.allocations);
+        phases.pushBack(phase);
+    }
+
+    Serde::Object counters;
+    for (auto& c : _registry().counters)
+        counters.put(String{c.v0}, c.v1);
+
+    Serde::Object result;
+    result.put("phases"s, phases);
+    result.put("counters"s, counters);
+    return result;
+}
+
+// The recorded spans in the Chrome trace event format. Spans are complete
+// events on a single thread, which Perfetto and chrome://tracing nest by
+// time, async spans are pairs of begin and end events matched by their id.
+export Serde::Value trace() {
+    Serde::Array events;
+    for (auto& e : _registry().events) {
+        Serde::Object event{
+            {"name"s, String{e.name}},
+            {"cat"s, "vaev"s},
+            {"ts"s, e.ts},
+            {"pid"s, 1},
+            {"tid"s, 1},
+        };
+        if (e.detail.len())
+            event.put("args"s, Serde::Object{{"detail"s, e.detail}});
+
+        if (auto [id] = e.id) {
+            event.put("ph"s, "b"s);
+            event.put("id"s, id);
+            events.pushBack(event);
+            events.pushBack(Serde::Object{
+                {"name"s, String{e.name}},
+                {"cat"s, "vaev"s},
+                {"ph"s, "e"s},
+                {"ts"s, e.ts + e.dur},
+                {"id"s, id},
+                {"pid"s, 1},
+                {"tid"s, 1},
+            });
+            continue;
+        }
+
+        event.put("ph"s, "X"s);
+        event.put("dur"s, e.dur);
+        events.pushBack(event);
+    }
+
+    return Serde::Object{
+        {"traceEvents"s, events},
+        {"displayTimeUnit"s, "ms"s},
+    };
+}
+
+} // namespace Vaev::Perf
@@ -641,6 +641,34 @@ export struct RegisteredPropertySet {
         registerProperty(registration->name(), registration);
     }
 
+    // MARK: Journal ---------------------------------------------------------
+
+    // Custom properties resolved through this set while a journal is open,
+    // so the ones a stylesheet refers to can be registered again in another
+    // set with adopt().
+    Opt<Map<Symbol, Rc<Property::Registration>>> _journal = NONE;
+
+    void openJournal() {
+        _journal = Map<Symbol, Rc<Property::Registration>>{};
+    }
+
+    Map<Symbol, Rc<Property::Registration>> closeJournal() {
+        return _journal.take();
+    }
+
+    void _record(Symbol const& propertyName, Rc<Property::Registration> const& registration) {
+        if (_journal and startWith(propertyName.str(), "--"s) != Match::NO)
+            _journal->put(propertyName, registration);
+    }
+
+    // Registers the properties of `registrations` that are missing from this
+    // set, the registrations are shared between both sets.
+    void adopt(Map<Symbol, Rc<Property::Registration>> const& registrations) {
+        for (auto const& [propertyName, registration] : registrations.iterItems())
+            if (not _registrations.lookup(propertyName))
+                registerProperty(propertyName, registration);
+    }
+
     Rc<Property::Registration> registerCustomProperty(Symbol const& propertyName) {
         auto registration = makeRc<CustomProperty::Registration>(propertyName);
         registration->_self = registration;
@@ -654,12 +682,17 @@ export struct RegisteredPropertySet {
                 .lookup(unresolvedPropertyName)
                 .unwrapOr(unresolvedPropertyName);
 
-        if (auto maybeRegistration = _registrations.lookup(propertyName))
+        if (auto maybeRegistration = _registrations.lookup(propertyName)) {
+            _record(propertyName, *maybeRegistration);
             return maybeRegistration.take();
+        }
 
         if (options.has(GENERATE_CUSTOM_PROPERTY)) {
-            if (startWith(propertyName.str(), "--"s) != Match::NO)
-                return registerCustomProperty(propertyName);
+            if (startWith(propertyName.str(), "--"s) != Match::NO) {
+                auto registration = registerCustomProperty(propertyName);
+                _record(propertyName, registration);
+                return registration;
+            }
         }
 
         if (options.has(GENERATE_BOGUS)) {
@@ -10,6 +10,7 @@ import Karm.Ref;
 
 import :dom.document;
 import :dom.element;
+import :perf;
 import :style.cascaded;
 import :style.computed;
 import :style.counter;
@@ -26,7 +27,8 @@ export struct Computer {
     RegisteredPropertySet& _registeredPropertySet;
     StyleSheetList const& _stylesheets;
     Rc<Font::Database> _fontDatabase;
-    RuleIndex _ruleIndex = {};
+    // NOTE: Shared between computers styling clones of the same document.
+    Rc<RuleIndex> _ruleIndex = makeRc<RuleIndex>();
     Viewport _viewport{.small = _media.viewportSize()};
     Opt<Rc<ComputedValues>> _rootComputedValues = NONE;
 
@@ -342,8 +344,8 @@ export struct Computer {
         if (el->qualifiedName.ns != Svg::NAMESPACE)
             return;
 
-        for (auto [attr, attrValue] : el->attributes.iterItems())
-            if (auto const& [property] = _registeredPropertySet.parsePresentationAttribute(attr.name, attrValue->value))
+        for (auto const& [attr, attrValue] : el->attributes)
+            if (auto const& [property] = _registeredPropertySet.parsePresentationAttribute(attr.name, attrValue))
                 cascadedValues.put(property, Origin::AUTHOR_PRESENTATIONAL_HINT, PRESENTATION_HINT_SPEC);
 
         if (el->qualifiedName == Svg::SVG_TAG)
@@ -358,7 +360,7 @@ export struct Computer {
         if (isRootElement)
             _rootComputedValues = values;
 
-        MatchingRules const matchingRules = _ruleIndex.match(el, pseudoElement);
+        MatchingRules const matchingRules = _ruleIndex->match(el, pseudoElement);
         CascadedValues cascadedValues;
         for (auto const& [styleRule, specificity] : matchingRules)
             for (auto& prop : styleRule->props)
@@ -401,7 +403,7 @@ export struct Computer {
         auto computed = makeRc<PageComputedValues>(_heap, parent);
 
         for (auto const& sheet : _stylesheets.items)
-            for (auto const& rule : sheet.rules)
+            for (auto const& rule : sheet->rules)
                 _evalRule(rule, page, *computed);
 
         for (auto& area : computed->_areas) {
@@ -432,6 +434,7 @@ export struct Computer {
     }
 
     void styleElement(ComputedValues const& parentComputedValues, Dom::Element& el) {
+        Perf::Span _{"styleElement", "{}", el.qualifiedName};
         auto computedValues = computeValues(parentComputedValues, el);
         el._computedValues = computedValues;
 
@@ -480,7 +483,7 @@ export struct Computer {
     CounterStyleSet _resolveCounterStyle(StyleSheetList const& stylesheets) {
         CounterDescriptorSet counters;
         for (auto const& sheet : stylesheets.items) {
-            for (auto const& rule : sheet.rules) {
+            for (auto const& rule : sheet->rules) {
                 if (auto it = rule.is<CounterRule>()) {
                     CounterDescriptors descriptor;
                     for (auto const& d : it->descriptors)
@@ -516,7 +519,7 @@ export struct Computer {
 
     void build() {
         for (auto const& sheet : _stylesheets.items) {
-            for (auto const& rule : sheet.rules) {
+            for (auto const& rule : sheet->rules) {
                 _addRuleToLookup(&rule);
             }
         }
@@ -525,7 +528,7 @@ export struct Computer {
     void _addRuleToLookup(Cursor<Rule> rule) {
         rule->visit(
             [&](StyleRule const& r) {
-                _ruleIndex.add(r);
+                _ruleIndex->add(r);
             },
             [&](MediaRule const& r) {
                 if (r.match(_media))
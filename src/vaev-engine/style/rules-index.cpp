@@ -170,9 +170,9 @@ struct RuleIndex {
 
         considerCursorIfPresent(_typeNameRules, element->qualifiedName.name);
 
-        for (auto const& [name, value] : element->attributes.iterItems()) {
+        for (auto const& [name, value] : element->attributes) {
             auto const& attrName = name.name;
-            auto key = Tuple{attrName, value->value.str()};
+            auto key = Tuple{attrName, value.str()};
 
             considerCursorIfPresent(_attrPresentRules, attrName);
             considerCursorIfPresent(_attrExactValueRules, key);
@@ -71,9 +71,15 @@ export struct StyleSheet {
 
 // https://drafts.csswg.org/cssom/#the-stylesheetlist-interface
 export struct StyleSheetList {
-    Vec<StyleSheet> items = {};
+    Vec<Rc<StyleSheet>> items = {};
 
     void add(StyleSheet&& sheet) {
+        items.pushBack(makeRc<StyleSheet>(std::move(sheet)));
+    }
+
+    // NOTE: Shared style sheets, like the user agent ones, must not be
+    //       modified once they are added to a list.
+    void add(Rc<StyleSheet> sheet) {
         items.pushBack(std::move(sheet));
     }
 